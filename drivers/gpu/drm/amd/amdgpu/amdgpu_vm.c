@@ -604,6 +604,10 @@ void amdgpu_vm_move_to_lru_tail(struct amdgpu_device *adev,
 	struct amdgpu_vm_bo_base *bo_base;
 
 	if (vm->bulk_moveable) {
+		/* Nobody else touched the LRU since our last bulk move */
+		if (ttm_bo_bulk_move_at_tail(&vm->lru_bulk_move))
+			return;
+
 		spin_lock(&glob->lru_lock);
 		ttm_bo_bulk_move_lru_tail(&vm->lru_bulk_move);
 		spin_unlock(&glob->lru_lock);
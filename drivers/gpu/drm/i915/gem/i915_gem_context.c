@@ -105,6 +105,8 @@ static void lut_close(struct i915_gem_context *ctx)
 
 	lockdep_assert_held(&ctx->mutex);
 
+	ctx->exec_cache.count = 0;
+
 	rcu_read_lock();
 	radix_tree_for_each_slot(slot, &ctx->handles_vma, &iter, 0) {
 		struct i915_vma *vma = rcu_dereference_raw(*slot);
@@ -324,6 +326,7 @@ static void i915_gem_context_free(struct i915_gem_context *ctx)
 	mutex_destroy(&ctx->engines_mutex);
 
 	kfree(ctx->jump_whitelist);
+	kfree(ctx->exec_cache.vma);
 
 	if (ctx->timeline)
 		intel_timeline_put(ctx->timeline);
@@ -197,6 +197,20 @@ struct i915_gem_context {
 	 */
 	struct radix_tree_root handles_vma;
 
+	/**
+	 * exec_cache: The object handles of the last execbuf on this context
+	 * and the vmas they resolved to, so that resubmitting the same list
+	 * skips the lookups in @handles_vma. The vmas are kept alive by
+	 * @handles_vma, so the cache is emptied whenever a handle is removed
+	 * from it. Guarded by @mutex.
+	 */
+	struct {
+		struct i915_vma **vma;
+		u32 *handles;
+		unsigned int count;
+		unsigned int size;
+	} exec_cache;
+
 	/** jump_whitelist: Bit array for tracking cmds during cmdparsing
 	 *  Guarded by struct_mutex
 	 */
@@ -748,6 +748,64 @@ static int eb_select_context(struct i915_execbuffer *eb)
 	return 0;
 }
 
+/*
+ * Lists larger than this are not worth keeping around between
+ * submissions, the per-object binding work dominates anyway.
+ */
+#define EB_EXEC_CACHE_MAX 4096
+
+static bool eb_exec_cache_hit(const struct i915_execbuffer *eb)
+{
+	const struct i915_gem_context *ctx = eb->gem_context;
+	unsigned int i;
+
+	lockdep_assert_held(&ctx->mutex);
+
+	if (ctx->exec_cache.count != eb->buffer_count)
+		return false;
+
+	for (i = 0; i < eb->buffer_count; i++) {
+		if (ctx->exec_cache.handles[i] != eb->exec[i].handle)
+			return false;
+	}
+
+	return true;
+}
+
+static void eb_exec_cache_store(const struct i915_execbuffer *eb)
+{
+	struct i915_gem_context *ctx = eb->gem_context;
+	unsigned int count = eb->buffer_count;
+	unsigned int i;
+
+	lockdep_assert_held(&ctx->mutex);
+
+	ctx->exec_cache.count = 0;
+	if (count > EB_EXEC_CACHE_MAX)
+		return;
+
+	if (count > ctx->exec_cache.size) {
+		struct i915_vma **vma;
+
+		/* One allocation for both the vma and the handle arrays */
+		vma = kmalloc_array(count, sizeof(*vma) + sizeof(u32),
+				    GFP_KERNEL | __GFP_NOWARN);
+		if (!vma)
+			return;
+
+		kfree(ctx->exec_cache.vma);
+		ctx->exec_cache.vma = vma;
+		ctx->exec_cache.handles = (u32 *)(vma + count);
+		ctx->exec_cache.size = count;
+	}
+
+	for (i = 0; i < count; i++) {
+		ctx->exec_cache.vma[i] = eb->vma[i];
+		ctx->exec_cache.handles[i] = eb->exec[i].handle;
+	}
+	ctx->exec_cache.count = count;
+}
+
 static int eb_lookup_vmas(struct i915_execbuffer *eb)
 {
 	struct radix_tree_root *handles_vma = &eb->gem_context->handles_vma;
@@ -769,6 +827,22 @@ static int eb_lookup_vmas(struct i915_execbuffer *eb)
 		goto err_ctx;
 	}
 
+	/*
+	 * Clients with a stable working set resubmit the very same list of
+	 * handles, so reuse the vmas they resolved to the last time.
+	 */
+	if (eb_exec_cache_hit(eb)) {
+		struct i915_vma **vmas = eb->gem_context->exec_cache.vma;
+
+		for (i = 0; i < eb->buffer_count; i++) {
+			err = eb_add_vma(eb, i, batch, vmas[i]);
+			if (unlikely(err))
+				goto err_vma;
+		}
+
+		goto out_unlock;
+	}
+
 	for (i = 0; i < eb->buffer_count; i++) {
 		u32 handle = eb->exec[i].handle;
 		struct i915_lut_handle *lut;
@@ -823,6 +897,9 @@ add_vma:
 			   eb_vma_misplaced(&eb->exec[i], vma, eb->flags[i]));
 	}
 
+	eb_exec_cache_store(eb);
+
+out_unlock:
 	mutex_unlock(&eb->gem_context->mutex);
 
 	eb->args->flags |= __EXEC_VALIDATED;
@@ -1448,14 +1525,40 @@ eb_relocate_entry(struct i915_execbuffer *eb,
 	return relocate_entry(vma, reloc, eb, target);
 }
 
+/*
+ * Order a batch of relocations by the page they patch, so that each page
+ * of the object is mapped once per batch by reloc_vaddr() rather than
+ * once per run of relocations. Insertion sort: it is stable, so writes to
+ * the same location keep their order, and userspace usually hands us
+ * relocations already sorted, which makes it linear.
+ */
+static void eb_sort_relocs(const struct drm_i915_gem_relocation_entry *r,
+			   u8 *order, unsigned int count)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < count; i++) {
+		u64 page = r[i].offset >> PAGE_SHIFT;
+
+		for (j = i; j && r[order[j - 1]].offset >> PAGE_SHIFT > page; j--)
+			order[j] = order[j - 1];
+		order[j] = i;
+	}
+}
+
 static int eb_relocate_vma(struct i915_execbuffer *eb, struct i915_vma *vma)
 {
 #define N_RELOC(x) ((x) / sizeof(struct drm_i915_gem_relocation_entry))
 	struct drm_i915_gem_relocation_entry stack[N_RELOC(512)];
 	struct drm_i915_gem_relocation_entry __user *urelocs;
 	const struct drm_i915_gem_exec_object2 *entry = exec_entry(eb, vma);
+	struct drm_i915_gem_relocation_entry *relocs = stack;
+	unsigned int max = ARRAY_SIZE(stack);
+	u8 order[N_RELOC(PAGE_SIZE)];
 	unsigned int remain;
 
+	BUILD_BUG_ON(N_RELOC(PAGE_SIZE) > U8_MAX + 1);
+
 	urelocs = u64_to_user_ptr(entry->relocs_ptr);
 	remain = entry->relocation_count;
 	if (unlikely(remain > N_RELOC(ULONG_MAX)))
@@ -1469,11 +1572,20 @@ static int eb_relocate_vma(struct i915_execbuffer *eb, struct i915_vma *vma)
 	if (unlikely(!access_ok(urelocs, remain*sizeof(*urelocs))))
 		return -EFAULT;
 
+	/* Process long relocation lists a page at a time */
+	if (remain > max) {
+		relocs = kmalloc(PAGE_SIZE, GFP_KERNEL | __GFP_NOWARN);
+		if (relocs)
+			max = N_RELOC(PAGE_SIZE);
+		else
+			relocs = stack;
+	}
+
 	do {
-		struct drm_i915_gem_relocation_entry *r = stack;
-		unsigned int count =
-			min_t(unsigned int, remain, ARRAY_SIZE(stack));
+		struct drm_i915_gem_relocation_entry *r = relocs;
+		unsigned int count = min_t(unsigned int, remain, max);
 		unsigned int copied;
+		unsigned int i;
 
 		/*
 		 * This is the fast path and we cannot handle a pagefault
@@ -1492,8 +1604,10 @@ static int eb_relocate_vma(struct i915_execbuffer *eb, struct i915_vma *vma)
 		}
 
 		remain -= count;
-		do {
-			u64 offset = eb_relocate_entry(eb, vma, r);
+		eb_sort_relocs(r, order, count);
+		for (i = 0; i < count; i++) {
+			unsigned int idx = order[i];
+			u64 offset = eb_relocate_entry(eb, vma, &r[idx]);
 
 			if (likely(offset == 0)) {
 			} else if ((s64)offset < 0) {
@@ -1522,16 +1636,18 @@ static int eb_relocate_vma(struct i915_execbuffer *eb, struct i915_vma *vma)
 				 * can read from this userspace address.
 				 */
 				offset = gen8_canonical_addr(offset & ~UPDATE);
-				if (unlikely(__put_user(offset, &urelocs[r-stack].presumed_offset))) {
+				if (unlikely(__put_user(offset, &urelocs[idx].presumed_offset))) {
 					remain = -EFAULT;
 					goto out;
 				}
 			}
-		} while (r++, --count);
-		urelocs += ARRAY_SIZE(stack);
+		}
+		urelocs += count;
 	} while (remain);
 out:
 	reloc_cache_reset(&eb->reloc_cache);
+	if (relocs != stack)
+		kfree(relocs);
 	return remain;
 }
 
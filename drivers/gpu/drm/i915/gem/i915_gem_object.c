@@ -120,6 +120,7 @@ void i915_gem_close_object(struct drm_gem_object *gem, struct drm_file *file)
 		mutex_lock(&ctx->mutex);
 		vma = radix_tree_delete(&ctx->handles_vma, lut->handle);
 		if (vma) {
+			ctx->exec_cache.count = 0;
 			GEM_BUG_ON(vma->obj != obj);
 			GEM_BUG_ON(!atomic_read(&vma->open_count));
 			if (atomic_dec_and_test(&vma->open_count) &&
@@ -270,6 +270,21 @@ i915_gem_object_has_pinned_pages(struct drm_i915_gem_object *obj)
 	return atomic_read(&obj->mm.pages_pin_count);
 }
 
+void i915_gem_object_unpark(struct drm_i915_gem_object *obj);
+
+/*
+ * Called after dropping a pin on the pages: if the shrinker parked the
+ * object for being pinned, return it to the shrinker once it can be reaped.
+ */
+static inline void
+i915_gem_object_check_parked(struct drm_i915_gem_object *obj)
+{
+	/* Pairs with the barrier in park() */
+	smp_mb__after_atomic();
+	if (unlikely(READ_ONCE(obj->mm.parked)))
+		i915_gem_object_unpark(obj);
+}
+
 static inline void
 __i915_gem_object_unpin_pages(struct drm_i915_gem_object *obj)
 {
@@ -277,6 +292,7 @@ __i915_gem_object_unpin_pages(struct drm_i915_gem_object *obj)
 	GEM_BUG_ON(!i915_gem_object_has_pinned_pages(obj));
 
 	atomic_dec(&obj->mm.pages_pin_count);
+	i915_gem_object_check_parked(obj);
 }
 
 static inline void
@@ -403,6 +419,7 @@ void i915_gem_object_unpin_from_display_plane(struct i915_vma *vma);
 void i915_gem_object_make_unshrinkable(struct drm_i915_gem_object *obj);
 void i915_gem_object_make_shrinkable(struct drm_i915_gem_object *obj);
 void i915_gem_object_make_purgeable(struct drm_i915_gem_object *obj);
+void __i915_gem_object_unpark(struct drm_i915_gem_object *obj);
 
 static inline bool cpu_write_needs_clflush(struct drm_i915_gem_object *obj)
 {
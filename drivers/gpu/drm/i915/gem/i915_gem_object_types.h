@@ -226,6 +226,12 @@ struct drm_i915_gem_object {
 		 * swizzling.
 		 */
 		bool quirked:1;
+
+		/**
+		 * Set while the object waits on i915->mm.shrink_parked,
+		 * locked by i915->mm.obj_lock.
+		 */
+		bool parked;
 	} mm;
 
 	/** Record of address bit 17 of each page at last unbind. */
@@ -182,6 +182,7 @@ void i915_gem_suspend_late(struct drm_i915_private *i915)
 	struct list_head *phases[] = {
 		&i915->mm.shrink_list,
 		&i915->mm.purge_list,
+		&i915->mm.shrink_parked,
 		NULL
 	}, **phase;
 	unsigned long flags;
@@ -13,7 +13,98 @@
 #include "i915_trace.h"
 
 #ifdef __FreeBSD__
+#include <vm/vm_pager.h>
+
 static inline unsigned long totalram_pages() { return physmem; }
+
+/*
+ * The vm object behind a GEM object is filled one page at a time from the
+ * free lists, which rarely leaves anything physically contiguous enough to
+ * be mapped with 64K or 2M GTT pages. Where the hardware can use them, try
+ * to back each untouched, naturally aligned chunk of the object with a
+ * single contiguous allocation before the pages are looked up. Anything we
+ * cannot get contiguously is left to the usual page by page path.
+ */
+static bool shmem_range_is_empty(vm_object_t vm_obj,
+				 vm_pindex_t start, unsigned long npages)
+{
+	vm_pindex_t i;
+	vm_page_t m;
+
+	VM_OBJECT_ASSERT_WLOCKED(vm_obj);
+
+	m = vm_page_find_least(vm_obj, start);
+	if (m != NULL && m->pindex < start + npages)
+		return false;
+
+	/* Don't shadow contents that have been paged out */
+	for (i = start; i < start + npages; i++) {
+		if (vm_pager_has_page(vm_obj, i, NULL, NULL))
+			return false;
+	}
+
+	return true;
+}
+
+static bool shmem_alloc_contig(vm_object_t vm_obj,
+			       vm_pindex_t start, unsigned long npages)
+{
+	vm_page_t m, end;
+	bool ret = false;
+
+	VM_OBJECT_WLOCK(vm_obj);
+	if (!shmem_range_is_empty(vm_obj, start, npages))
+		goto out;
+
+	m = vm_page_alloc_contig(vm_obj, start,
+				 VM_ALLOC_NORMAL | VM_ALLOC_NOWAIT |
+				 VM_ALLOC_ZERO,
+				 npages, 0, ~(vm_paddr_t)0, ptoa(npages), 0,
+				 VM_MEMATTR_DEFAULT);
+	if (m == NULL)
+		goto out;
+
+	for (end = m + npages; m < end; m++) {
+		if ((m->flags & PG_ZERO) == 0)
+			pmap_zero_page(m);
+		vm_page_valid(m);
+		vm_page_xunbusy(m);
+	}
+	ret = true;
+out:
+	VM_OBJECT_WUNLOCK(vm_obj);
+	return ret;
+}
+
+static void shmem_prealloc_contig(struct drm_i915_gem_object *obj)
+{
+	struct drm_i915_private *i915 = to_i915(obj->base.dev);
+	const unsigned long page_count = obj->base.size >> PAGE_SHIFT;
+	const unsigned long huge = I915_GTT_PAGE_SIZE_2M >> PAGE_SHIFT;
+	const unsigned long medium = I915_GTT_PAGE_SIZE_64K >> PAGE_SHIFT;
+	vm_object_t vm_obj = obj->base.filp->f_shmem;
+	bool use_huge = HAS_PAGE_SIZES(i915, I915_GTT_PAGE_SIZE_2M);
+	unsigned long i;
+
+	if (!HAS_PAGE_SIZES(i915, I915_GTT_PAGE_SIZE_64K))
+		return;
+
+	for (i = 0; i + medium <= page_count; ) {
+		if (use_huge && IS_ALIGNED(i, huge) && i + huge <= page_count) {
+			if (shmem_alloc_contig(vm_obj, i, huge)) {
+				i += huge;
+				continue;
+			}
+
+			/* Don't keep trying if the free lists are fragmented */
+			use_huge = false;
+		}
+
+		shmem_alloc_contig(vm_obj, i, medium);
+		i += medium;
+		cond_resched();
+	}
+}
 #endif
 
 /*
@@ -27,6 +118,114 @@ static void check_release_pagevec(struct pagevec *pvec)
 	cond_resched();
 }
 
+/*
+ * Faulting in the shmem pages of a large object is dominated by allocating
+ * and clearing each page, so for large objects we first populate the
+ * mapping from several workers and only then build the sg_table from the
+ * pages they found. The workers never reclaim; any page they could not get
+ * is left for the main loop to retry with the shrinker.
+ */
+#define SHMEM_PREFETCH_MIN_PAGES (SZ_64M >> PAGE_SHIFT)
+#define SHMEM_PREFETCH_MAX_WORKERS 8
+
+struct shmem_prefetch {
+	struct work_struct work;
+#ifdef __FreeBSD__
+	vm_object_t mapping;
+#else
+	struct address_space *mapping;
+#endif
+	struct page **pages;
+	unsigned long start;
+	unsigned long end;
+	gfp_t gfp;
+};
+
+static void shmem_prefetch_range(struct shmem_prefetch *p)
+{
+	unsigned long i;
+
+	for (i = p->start; i < p->end; i++) {
+		struct page *page;
+
+		page = shmem_read_mapping_page_gfp(p->mapping, i, p->gfp);
+		if (IS_ERR(page))
+			break;
+
+		p->pages[i] = page;
+		cond_resched();
+	}
+}
+
+static void shmem_prefetch_work(struct work_struct *work)
+{
+	shmem_prefetch_range(container_of(work, struct shmem_prefetch, work));
+}
+
+static struct page **shmem_prefetch_pages(struct drm_i915_gem_object *obj,
+					  unsigned long page_count,
+					  gfp_t gfp)
+{
+	unsigned int n = min_t(unsigned int, num_online_cpus(),
+			       SHMEM_PREFETCH_MAX_WORKERS);
+	struct shmem_prefetch *p;
+	struct page **pages;
+	unsigned long chunk;
+	unsigned int i;
+
+	if (page_count < SHMEM_PREFETCH_MIN_PAGES || n < 2)
+		return NULL;
+
+	pages = kvmalloc_array(page_count, sizeof(*pages),
+			       GFP_KERNEL | __GFP_ZERO | __GFP_NOWARN);
+	if (!pages)
+		return NULL;
+
+	p = kmalloc_array(n, sizeof(*p), GFP_KERNEL | __GFP_NOWARN);
+	if (!p) {
+		kvfree(pages);
+		return NULL;
+	}
+
+	chunk = DIV_ROUND_UP(page_count, n);
+	for (i = 0; i < n; i++) {
+#ifdef __FreeBSD__
+		p[i].mapping = obj->base.filp->f_shmem;
+#else
+		p[i].mapping = obj->base.filp->f_mapping;
+#endif
+		p[i].pages = pages;
+		p[i].start = min(i * chunk, page_count);
+		p[i].end = min(p[i].start + chunk, page_count);
+		p[i].gfp = gfp;
+		INIT_WORK(&p[i].work, shmem_prefetch_work);
+		if (i)
+			queue_work(system_unbound_wq, &p[i].work);
+	}
+
+	shmem_prefetch_range(&p[0]);
+	for (i = 1; i < n; i++)
+		flush_work(&p[i].work);
+
+	kfree(p);
+	return pages;
+}
+
+static void shmem_prefetch_release(struct page **pages,
+				   unsigned long page_count)
+{
+	unsigned long i;
+
+	if (!pages)
+		return;
+
+	for (i = 0; i < page_count; i++) {
+		if (pages[i])
+			put_page(pages[i]);
+	}
+	kvfree(pages);
+}
+
 static int shmem_get_pages(struct drm_i915_gem_object *obj)
 {
 	struct drm_i915_private *i915 = to_i915(obj->base.dev);
@@ -40,7 +239,7 @@ static int shmem_get_pages(struct drm_i915_gem_object *obj)
 	struct sg_table *st;
 	struct scatterlist *sg;
 	struct sgt_iter sgt_iter;
-	struct page *page;
+	struct page *page, **prefetch;
 	unsigned long last_pfn = 0;	/* suppress gcc warning */
 	unsigned int max_segment = i915_sg_segment_size();
 	unsigned int sg_page_sizes;
@@ -89,6 +288,12 @@ rebuild_st:
 #endif
 	noreclaim |= __GFP_NORETRY | __GFP_NOWARN;
 
+#ifdef __FreeBSD__
+	if (max_segment > PAGE_SIZE)
+		shmem_prealloc_contig(obj);
+#endif
+	prefetch = shmem_prefetch_pages(obj, page_count, noreclaim);
+
 	sg = st->sgl;
 	st->nents = 0;
 	sg_page_sizes = 0;
@@ -101,6 +306,11 @@ rebuild_st:
 
 		do {
 			cond_resched();
+			if (prefetch && prefetch[i]) {
+				page = fetch_and_zero(&prefetch[i]);
+				break;
+			}
+
 			page = shmem_read_mapping_page_gfp(mapping, i, gfp);
 			if (!IS_ERR(page))
 				break;
@@ -166,6 +376,7 @@ rebuild_st:
 		sg_page_sizes |= sg->length;
 		sg_mark_end(sg);
 	}
+	shmem_prefetch_release(prefetch, page_count);
 
 	/* Trim unused sg entries to avoid wasting memory. */
 	i915_sg_trim(st);
@@ -201,6 +412,7 @@ rebuild_st:
 
 err_sg:
 	sg_mark_end(sg);
+	shmem_prefetch_release(prefetch, page_count);
 err_pages:
 	mapping_clear_unevictable(mapping);
 	pagevec_init(&pvec);
@@ -55,13 +55,9 @@ static bool swap_available(void)
 	return get_nr_swap_pages() > 0;
 }
 
-static bool can_release_pages(struct drm_i915_gem_object *obj)
+static bool pages_pinned(struct drm_i915_gem_object *obj)
 {
-	/* Consider only shrinkable ojects. */
-	if (!i915_gem_object_is_shrinkable(obj))
-		return false;
-
-	/* Only report true if by unbinding the object and putting its pages
+	/* Only report false if by unbinding the object and putting its pages
 	 * we can actually make forward progress towards freeing physical
 	 * pages.
 	 *
@@ -70,7 +66,7 @@ static bool can_release_pages(struct drm_i915_gem_object *obj)
 	 * in releasing our pin count on the pages themselves.
 	 */
 	if (atomic_read(&obj->mm.pages_pin_count) > atomic_read(&obj->bind_count))
-		return false;
+		return true;
 
 	/* If any vma are "permanently" pinned, it will prevent us from
 	 * reclaiming the obj->mm.pages. We only allow scanout objects to claim
@@ -78,7 +74,16 @@ static bool can_release_pages(struct drm_i915_gem_object *obj)
 	 * To simplify the scan, and to avoid walking the list of vma under the
 	 * object, we just check the count of its permanently pinned.
 	 */
-	if (READ_ONCE(obj->pin_global))
+	return READ_ONCE(obj->pin_global);
+}
+
+static bool can_release_pages(struct drm_i915_gem_object *obj)
+{
+	/* Consider only shrinkable ojects. */
+	if (!i915_gem_object_is_shrinkable(obj))
+		return false;
+
+	if (pages_pinned(obj))
 		return false;
 
 	/* We can only return physical pages to the system if we can either
@@ -88,6 +93,98 @@ static bool can_release_pages(struct drm_i915_gem_object *obj)
 	return swap_available() || obj->mm.madv == I915_MADV_DONTNEED;
 }
 
+/*
+ * Objects whose pages are pinned cannot be reclaimed however often we look
+ * at them, and under memory pressure rescanning them on every call is what
+ * makes the shrinker linear in the number of objects. Instead, move them
+ * aside onto mm.shrink_parked and leave them out of the reclaimable count
+ * until they are reconsidered: as soon as the pin is dropped (see
+ * i915_gem_object_check_parked()), when the object is moved back onto its
+ * list (madvise, set-domain or dropping its display pin), when we are asked
+ * to shrink everything, or at most once every I915_SHRINK_UNPARK_INTERVAL
+ * when we run short of other candidates.
+ */
+#define I915_SHRINK_UNPARK_INTERVAL (HZ / 10)
+
+static bool park(struct drm_i915_private *i915,
+		 struct drm_i915_gem_object *obj)
+{
+	lockdep_assert_held(&i915->mm.obj_lock);
+	GEM_BUG_ON(obj->mm.parked);
+
+	/*
+	 * Publish that we are parking before sampling the pin counts, so
+	 * that whoever drops the last pin either sees the object parked
+	 * or we see it unpinned. Pairs with i915_gem_object_check_parked().
+	 */
+	WRITE_ONCE(obj->mm.parked, true);
+	smp_mb();
+	if (!pages_pinned(obj)) {
+		WRITE_ONCE(obj->mm.parked, false);
+		return false;
+	}
+
+	list_move_tail(&obj->mm.link, &i915->mm.shrink_parked);
+	i915->mm.shrink_parked_count++;
+	i915->mm.shrink_parked_memory += obj->base.size;
+	return true;
+}
+
+void __i915_gem_object_unpark(struct drm_i915_gem_object *obj)
+{
+	struct drm_i915_private *i915 = to_i915(obj->base.dev);
+
+	lockdep_assert_held(&i915->mm.obj_lock);
+
+	if (!obj->mm.parked)
+		return;
+
+	WRITE_ONCE(obj->mm.parked, false);
+	i915->mm.shrink_parked_count--;
+	i915->mm.shrink_parked_memory -= obj->base.size;
+}
+
+static void unpark(struct drm_i915_private *i915,
+		   struct drm_i915_gem_object *obj)
+{
+	struct list_head *list;
+
+	if (obj->mm.madv != I915_MADV_WILLNEED)
+		list = &i915->mm.purge_list;
+	else
+		list = &i915->mm.shrink_list;
+
+	__i915_gem_object_unpark(obj);
+	list_move_tail(&obj->mm.link, list);
+}
+
+void i915_gem_object_unpark(struct drm_i915_gem_object *obj)
+{
+	struct drm_i915_private *i915 = to_i915(obj->base.dev);
+	unsigned long flags;
+
+	spin_lock_irqsave(&i915->mm.obj_lock, flags);
+	if (obj->mm.parked && !pages_pinned(obj))
+		unpark(i915, obj);
+	spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
+}
+
+static bool unpark_all(struct drm_i915_private *i915)
+{
+	struct drm_i915_gem_object *obj, *next;
+	unsigned long flags;
+	bool found;
+
+	spin_lock_irqsave(&i915->mm.obj_lock, flags);
+	found = !list_empty(&i915->mm.shrink_parked);
+	list_for_each_entry_safe(obj, next, &i915->mm.shrink_parked, mm.link)
+		unpark(i915, obj);
+	i915->mm.shrink_unpark_time = jiffies;
+	spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
+
+	return found;
+}
+
 static bool unsafe_drop_pages(struct drm_i915_gem_object *obj,
 			      unsigned long shrink)
 {
@@ -162,11 +259,20 @@ i915_gem_shrink(struct drm_i915_private *i915,
 	intel_wakeref_t wakeref = 0;
 	unsigned long count = 0;
 	unsigned long scanned = 0;
+	bool unparked = false;
 	bool unlock;
 
+	/* Pages pinned on behalf of freed userptr objects go first */
+	if (shrink & I915_SHRINK_UNBOUND)
+		i915_gem_userptr_shrink(i915);
+
 	if (!shrinker_lock(i915, shrink, &unlock))
 		return 0;
 
+	/* Asked to release everything, so look at everything */
+	if (target == -1UL)
+		unparked = unpark_all(i915);
+
 	/*
 	 * When shrinking the active list, we should also consider active
 	 * contexts. Active contexts are pinned until they are retired, and
@@ -208,6 +314,7 @@ i915_gem_shrink(struct drm_i915_private *i915,
 	 * dev->struct_mutex and so we won't ever be able to observe an
 	 * object on the bound_list with a reference count equals 0.
 	 */
+again:
 	for (phase = phases; phase->list; phase++) {
 		struct list_head still_in_list;
 		struct drm_i915_gem_object *obj;
@@ -244,6 +351,11 @@ i915_gem_shrink(struct drm_i915_private *i915,
 			    atomic_read(&obj->bind_count))
 				continue;
 
+			if (!(shrink & I915_SHRINK_ACTIVE) &&
+			    i915_gem_object_is_shrinkable(obj) &&
+			    pages_pinned(obj) && park(i915, obj))
+				continue;
+
 			if (!can_release_pages(obj))
 				continue;
 
@@ -272,6 +384,19 @@ i915_gem_shrink(struct drm_i915_private *i915,
 		spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
 	}
 
+	/*
+	 * If we ran out of candidates, give the parked objects another look
+	 * in case they have since been unpinned, but not so often that we
+	 * end up rescanning them on every call.
+	 */
+	if (count < target && !unparked &&
+	    time_after(jiffies, READ_ONCE(i915->mm.shrink_unpark_time) +
+				I915_SHRINK_UNPARK_INTERVAL) &&
+	    unpark_all(i915)) {
+		unparked = true;
+		goto again;
+	}
+
 	if (shrink & I915_SHRINK_BOUND)
 		intel_runtime_pm_put(&i915->runtime_pm, wakeref);
 
@@ -316,11 +441,19 @@ i915_gem_shrinker_count(struct shrinker *shrinker, struct shrink_control *sc)
 {
 	struct drm_i915_private *i915 =
 		container_of(shrinker, struct drm_i915_private, mm.shrinker);
-	unsigned long num_objects;
+	unsigned long num_objects, num_parked;
+	u64 memory, parked;
 	unsigned long count;
 
-	count = READ_ONCE(i915->mm.shrink_memory) >> PAGE_SHIFT;
+	/* Parked objects are known to be pinned, so don't advertise them */
+	memory = READ_ONCE(i915->mm.shrink_memory);
+	parked = READ_ONCE(i915->mm.shrink_parked_memory);
+	count = memory > parked ? (memory - parked) >> PAGE_SHIFT : 0;
+	count += atomic_long_read(&i915->mm.userptr_cache_pages);
+
 	num_objects = READ_ONCE(i915->mm.shrink_count);
+	num_parked = READ_ONCE(i915->mm.shrink_parked_count);
+	num_objects = num_objects > num_parked ? num_objects - num_parked : 0;
 
 	/*
 	 * Update our preferred vmscan batch size for the next pass.
@@ -407,6 +540,7 @@ i915_gem_shrinker_oom(struct notifier_block *nb, unsigned long event, void *ptr)
 		else
 			available += obj->base.size >> PAGE_SHIFT;
 	}
+	unevictable += i915->mm.shrink_parked_memory >> PAGE_SHIFT;
 	spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
 
 	if (freed_pages || available)
@@ -540,6 +674,7 @@ void i915_gem_object_make_unshrinkable(struct drm_i915_gem_object *obj)
 		spin_lock_irqsave(&i915->mm.obj_lock, flags);
 		GEM_BUG_ON(list_empty(&obj->mm.link));
 
+		__i915_gem_object_unpark(obj);
 		list_del_init(&obj->mm.link);
 		i915->mm.shrink_count--;
 		i915->mm.shrink_memory -= obj->base.size;
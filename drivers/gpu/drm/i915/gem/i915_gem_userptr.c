@@ -30,6 +30,8 @@ struct i915_mm_struct {
 	struct work_struct work;
 };
 
+static void __i915_mm_struct_free(struct kref *kref);
+
 #if defined(CONFIG_MMU_NOTIFIER)
 #include <linux/interval_tree.h>
 
@@ -39,14 +41,40 @@ struct i915_mmu_notifier {
 	struct mmu_notifier mn;
 	struct rb_root_cached objects;
 	struct i915_mm_struct *mm;
+	struct list_head cache;
+	unsigned long cached_pages;
+	struct delayed_work expire;
 };
 
 struct i915_mmu_object {
 	struct i915_mmu_notifier *mn;
 	struct drm_i915_gem_object *obj;
 	struct interval_tree_node it;
+	bool stale;
 };
 
+/*
+ * Userspace often registers the same host buffer over and over again, and
+ * pinning all of its pages is the bulk of the cost of a userptr object. So
+ * when an object is freed, keep its pages pinned for up to
+ * I915_USERPTR_CACHE_EXPIRE in case the same range comes back. The pages sit
+ * in the interval tree next to the live objects (with no @obj) so that any
+ * invalidation of the range drops them, and they are dropped when the mm
+ * exits or the shrinker runs.
+ */
+struct i915_mmu_pages {
+	struct i915_mmu_object mo;
+	struct list_head link;
+	struct work_struct work;
+	struct page **pvec;
+	unsigned long npages;
+	unsigned long expires;
+	bool readonly;
+};
+
+#define I915_USERPTR_CACHE_PAGES (SZ_256M >> PAGE_SHIFT)
+#define I915_USERPTR_CACHE_EXPIRE HZ
+
 static void add_object(struct i915_mmu_object *mo)
 {
 	GEM_BUG_ON(!RB_EMPTY_NODE(&mo->it.rb));
@@ -62,6 +90,61 @@ static void del_object(struct i915_mmu_object *mo)
 	RB_CLEAR_NODE(&mo->it.rb);
 }
 
+static void __i915_mmu_pages_free(struct work_struct *work)
+{
+	struct i915_mmu_pages *mp = container_of(work, typeof(*mp), work);
+	struct i915_mm_struct *mm = mp->mo.mn->mm;
+
+	release_pages(mp->pvec, mp->npages);
+	kvfree(mp->pvec);
+	kfree(mp);
+
+	kref_put_mutex(&mm->kref, __i915_mm_struct_free, &mm->i915->mm_lock);
+}
+
+static void
+i915_mmu_pages_discard(struct i915_mmu_notifier *mn, struct i915_mmu_pages *mp)
+{
+	lockdep_assert_held(&mn->lock);
+
+	del_object(&mp->mo);
+	list_del(&mp->link);
+	mn->cached_pages -= mp->npages;
+	atomic_long_sub(mp->npages, &mn->mm->i915->mm.userptr_cache_pages);
+
+	queue_work(mn->mm->i915->mm.userptr_wq, &mp->work);
+}
+
+static void i915_mmu_pages_discard_all(struct i915_mmu_notifier *mn)
+{
+	struct i915_mmu_pages *mp, *next;
+
+	spin_lock(&mn->lock);
+	list_for_each_entry_safe(mp, next, &mn->cache, link)
+		i915_mmu_pages_discard(mn, mp);
+	spin_unlock(&mn->lock);
+}
+
+static void i915_mmu_pages_expire(struct work_struct *work)
+{
+	struct i915_mmu_notifier *mn =
+		container_of(work, typeof(*mn), expire.work);
+	struct i915_mmu_pages *mp, *next;
+
+	/* The cache is kept in order of insertion, oldest last */
+	spin_lock(&mn->lock);
+	list_for_each_entry_safe_reverse(mp, next, &mn->cache, link) {
+		if (time_before(jiffies, mp->expires)) {
+			schedule_delayed_work(&mn->expire,
+					      mp->expires - jiffies);
+			break;
+		}
+
+		i915_mmu_pages_discard(mn, mp);
+	}
+	spin_unlock(&mn->lock);
+}
+
 static void
 __i915_gem_userptr_set_active(struct drm_i915_gem_object *obj, bool value)
 {
@@ -109,8 +192,21 @@ userptr_mn_invalidate_range_start(struct mmu_notifier *_mn,
 	spin_lock(&mn->lock);
 	it = interval_tree_iter_first(&mn->objects, range->start, end);
 	while (it) {
+		struct i915_mmu_object *mo =
+			container_of(it, struct i915_mmu_object, it);
 		struct drm_i915_gem_object *obj;
 
+		/* Pages kept from a freed object, simply drop them */
+		if (!mo->obj) {
+			struct i915_mmu_pages *mp =
+				container_of(mo, typeof(*mp), mo);
+
+			i915_mmu_pages_discard(mn, mp);
+			it = interval_tree_iter_first(&mn->objects,
+						      range->start, end);
+			continue;
+		}
+
 		if (!mmu_notifier_range_blockable(range)) {
 			ret = -EAGAIN;
 			break;
@@ -126,8 +222,10 @@ userptr_mn_invalidate_range_start(struct mmu_notifier *_mn,
 		 * use-after-free we only acquire a reference on the
 		 * object if it is not in the process of being destroyed.
 		 */
-		obj = container_of(it, struct i915_mmu_object, it)->obj;
+		obj = mo->obj;
 		if (!kref_get_unless_zero(&obj->base.refcount)) {
+			/* Make sure its pages are not kept past the free */
+			mo->stale = true;
 			it = interval_tree_iter_next(it, range->start, end);
 			continue;
 		}
@@ -180,10 +278,157 @@ unlock:
 
 }
 
+static void
+userptr_mn_release(struct mmu_notifier *_mn, struct mm_struct *mm)
+{
+	struct i915_mmu_notifier *mn =
+		container_of(_mn, struct i915_mmu_notifier, mn);
+
+	i915_mmu_pages_discard_all(mn);
+}
+
 static const struct mmu_notifier_ops i915_gem_userptr_notifier = {
 	.invalidate_range_start = userptr_mn_invalidate_range_start,
+	.release = userptr_mn_release,
 };
 
+/*
+ * Called as the pages of an object are released. If the object is being
+ * freed, swap it for a cache entry holding on to its pages in the interval
+ * tree, so that there is no window in which an invalidation is missed.
+ */
+static bool
+i915_mmu_pages_stash(struct drm_i915_gem_object *obj, struct sg_table *pages)
+{
+	struct i915_mmu_object *mo = obj->userptr.mmu_object;
+	const unsigned long npages = obj->base.size >> PAGE_SHIFT;
+	struct i915_mmu_notifier *mn;
+	struct i915_mmu_pages *mp;
+	struct sgt_iter sgt_iter;
+	struct page *page;
+	unsigned long i;
+
+	/* Not when we are being reclaimed or invalidated */
+	if (!mo || kref_read(&obj->base.refcount))
+		return false;
+
+	if (npages > I915_USERPTR_CACHE_PAGES)
+		return false;
+
+	mp = kmalloc(sizeof(*mp), GFP_KERNEL | __GFP_NORETRY | __GFP_NOWARN);
+	if (!mp)
+		return false;
+
+	mp->pvec = kvmalloc_array(npages, sizeof(*mp->pvec),
+				  GFP_KERNEL | __GFP_NORETRY | __GFP_NOWARN);
+	if (!mp->pvec) {
+		kfree(mp);
+		return false;
+	}
+
+	i = 0;
+	for_each_sgt_page(page, sgt_iter, pages)
+		mp->pvec[i++] = page;
+	GEM_BUG_ON(i != npages);
+
+	mn = mo->mn;
+	mp->mo.mn = mn;
+	mp->mo.obj = NULL;
+	mp->mo.it.start = mo->it.start;
+	mp->mo.it.last = mo->it.last;
+	mp->mo.stale = false;
+	RB_CLEAR_NODE(&mp->mo.it.rb);
+	mp->npages = npages;
+	mp->expires = jiffies + I915_USERPTR_CACHE_EXPIRE;
+	mp->readonly = i915_gem_object_is_readonly(obj);
+	INIT_WORK(&mp->work, __i915_mmu_pages_free);
+
+	spin_lock(&mn->lock);
+	if (RB_EMPTY_NODE(&mo->it.rb) || mo->stale) {
+		spin_unlock(&mn->lock);
+		kvfree(mp->pvec);
+		kfree(mp);
+		return false;
+	}
+
+	while (mn->cached_pages + npages > I915_USERPTR_CACHE_PAGES)
+		i915_mmu_pages_discard(mn, list_last_entry(&mn->cache,
+							   typeof(*mp),
+							   link));
+
+	del_object(mo);
+	add_object(&mp->mo);
+	list_add(&mp->link, &mn->cache);
+	mn->cached_pages += npages;
+	atomic_long_add(npages, &mn->mm->i915->mm.userptr_cache_pages);
+	kref_get(&mn->mm->kref);
+	spin_unlock(&mn->lock);
+
+	/* No-op if already pending for an older entry */
+	schedule_delayed_work(&mn->expire, I915_USERPTR_CACHE_EXPIRE);
+
+	return true;
+}
+
+/*
+ * Look for the pages of a previously freed object covering exactly our
+ * range. On success the object takes over their place in the interval
+ * tree and is left active.
+ */
+static struct page **
+i915_mmu_pages_take(struct drm_i915_gem_object *obj)
+{
+	struct i915_mmu_object *mo = obj->userptr.mmu_object;
+	const unsigned long npages = obj->base.size >> PAGE_SHIFT;
+	struct i915_mmu_pages *mp, *found = NULL;
+	struct i915_mmu_notifier *mn;
+	struct page **pvec;
+
+	if (!mo)
+		return NULL;
+
+	mn = mo->mn;
+	if (list_empty(&mn->cache))
+		return NULL;
+
+	spin_lock(&mn->lock);
+	list_for_each_entry(mp, &mn->cache, link) {
+		if (mp->mo.it.start != obj->userptr.ptr ||
+		    mp->npages != npages)
+			continue;
+
+		/* Read-only pins may be shared with a COW mapping */
+		if (mp->readonly && !i915_gem_object_is_readonly(obj))
+			continue;
+
+		found = mp;
+		break;
+	}
+	if (found && RB_EMPTY_NODE(&mo->it.rb)) {
+		del_object(&found->mo);
+		list_del(&found->link);
+		mn->cached_pages -= npages;
+		atomic_long_sub(npages,
+				&mn->mm->i915->mm.userptr_cache_pages);
+		add_object(mo);
+	} else {
+		found = NULL;
+	}
+	spin_unlock(&mn->lock);
+
+	if (!found)
+		return NULL;
+
+	pvec = found->pvec;
+	kfree(found);
+
+	/* The object still holds its own reference to the mm */
+	kref_put_mutex(&mn->mm->kref, __i915_mm_struct_free,
+		       &mn->mm->i915->mm_lock);
+
+	return pvec;
+}
+
 static struct i915_mmu_notifier *
 i915_mmu_notifier_create(struct i915_mm_struct *mm)
 {
@@ -197,6 +442,9 @@ i915_mmu_notifier_create(struct i915_mm_struct *mm)
 	mn->mn.ops = &i915_gem_userptr_notifier;
 	mn->objects = RB_ROOT_CACHED;
 	mn->mm = mm;
+	INIT_LIST_HEAD(&mn->cache);
+	mn->cached_pages = 0;
+	INIT_DELAYED_WORK(&mn->expire, i915_mmu_pages_expire);
 
 	return mn;
 }
@@ -294,9 +542,34 @@ i915_mmu_notifier_free(struct i915_mmu_notifier *mn,
 		return;
 
 	mmu_notifier_unregister(&mn->mn, mm);
+	cancel_delayed_work_sync(&mn->expire);
 	kfree(mn);
 }
 
+/*
+ * Called from the shrinker to give back the pages held for freed objects.
+ * We may have been called from an allocation under mm_lock, so don't wait
+ * for it.
+ */
+void i915_gem_userptr_shrink(struct drm_i915_private *dev_priv)
+{
+	struct i915_mm_struct *mm;
+	int bkt;
+
+	if (!atomic_long_read(&dev_priv->mm.userptr_cache_pages))
+		return;
+
+	if (!mutex_trylock(&dev_priv->mm_lock))
+		return;
+
+	/* Protected by dev_priv->mm_lock */
+	hash_for_each(dev_priv->mm_structs, bkt, mm, node)
+		if (mm->mn)
+			i915_mmu_pages_discard_all(mm->mn);
+
+	mutex_unlock(&dev_priv->mm_lock);
+}
+
 #else
 
 static void
@@ -328,6 +601,22 @@ i915_mmu_notifier_free(struct i915_mmu_notifier *mn,
 {
 }
 
+static bool
+i915_mmu_pages_stash(struct drm_i915_gem_object *obj, struct sg_table *pages)
+{
+	return false;
+}
+
+static struct page **
+i915_mmu_pages_take(struct drm_i915_gem_object *obj)
+{
+	return NULL;
+}
+
+void i915_gem_userptr_shrink(struct drm_i915_private *dev_priv)
+{
+}
+
 #endif
 
 static struct i915_mm_struct *
@@ -472,6 +761,134 @@ alloc_table:
 	return st;
 }
 
+/*
+ * Faulting in a large range is dominated by walking the page tables one page
+ * at a time, and mmap_sem is only taken for read, so split large ranges
+ * between a few workers.
+ */
+#define USERPTR_GUP_PARALLEL_PAGES (SZ_16M >> PAGE_SHIFT)
+#define USERPTR_GUP_MAX_WORKERS 4
+
+struct userptr_gup {
+	struct work_struct work;
+	struct task_struct *task;
+	struct mm_struct *mm;
+	unsigned long start;
+	struct page **pvec;
+	int npages;
+	int pinned;
+	unsigned int flags;
+	int err;
+};
+
+static void userptr_gup_range(struct userptr_gup *gup)
+{
+	down_read(&gup->mm->mmap_sem);
+	while (gup->pinned < gup->npages) {
+		int ret;
+
+		ret = get_user_pages_remote
+			(gup->task, gup->mm,
+			 gup->start + gup->pinned * PAGE_SIZE,
+			 gup->npages - gup->pinned,
+			 gup->flags,
+#ifdef __linux__
+			 gup->pvec + gup->pinned, NULL, NULL);
+#elif defined(__FreeBSD__)
+			 gup->pvec + gup->pinned, NULL);
+#endif
+		if (ret < 0) {
+			gup->err = ret;
+			break;
+		}
+
+		gup->pinned += ret;
+	}
+	up_read(&gup->mm->mmap_sem);
+}
+
+static void userptr_gup_work(struct work_struct *work)
+{
+	userptr_gup_range(container_of(work, struct userptr_gup, work));
+}
+
+/*
+ * Pin all of [start, start + npages) into pvec. Returns 0 on success, or an
+ * error with none of the pages left pinned. The caller holds a reference
+ * on the mm.
+ */
+static int
+userptr_gup(struct task_struct *task, struct mm_struct *mm,
+	    unsigned long start, int npages, unsigned int flags,
+	    struct page **pvec)
+{
+	struct userptr_gup *gup;
+	int nworkers, chunk, i, err;
+
+	nworkers = 1;
+	if (npages >= 2 * USERPTR_GUP_PARALLEL_PAGES)
+		nworkers = min3(npages / USERPTR_GUP_PARALLEL_PAGES,
+				(int)num_online_cpus(),
+				USERPTR_GUP_MAX_WORKERS);
+
+	gup = NULL;
+	if (nworkers > 1)
+		gup = kcalloc(nworkers, sizeof(*gup), GFP_KERNEL);
+	if (!gup) {
+		struct userptr_gup single = {
+			.task = task,
+			.mm = mm,
+			.start = start,
+			.pvec = pvec,
+			.npages = npages,
+			.flags = flags,
+		};
+
+		userptr_gup_range(&single);
+		if (single.pinned == npages)
+			return 0;
+
+		release_pages(pvec, single.pinned);
+		return single.err ?: -EFAULT;
+	}
+
+	chunk = DIV_ROUND_UP(npages, nworkers);
+	for (i = 0; i < nworkers; i++) {
+		int first = i * chunk;
+
+		gup[i].task = task;
+		gup[i].mm = mm;
+		gup[i].start = start + (unsigned long)first * PAGE_SIZE;
+		gup[i].pvec = pvec + first;
+		gup[i].npages = min(chunk, npages - first);
+		gup[i].flags = flags;
+		INIT_WORK(&gup[i].work, userptr_gup_work);
+
+		/* The first chunk is done by ourselves */
+		if (i)
+			queue_work(system_unbound_wq, &gup[i].work);
+	}
+
+	userptr_gup_range(&gup[0]);
+
+	err = 0;
+	for (i = 0; i < nworkers; i++) {
+		if (i)
+			flush_work(&gup[i].work);
+
+		if (gup[i].pinned != gup[i].npages && !err)
+			err = gup[i].err ?: -EFAULT;
+	}
+
+	if (err) {
+		for (i = 0; i < nworkers; i++)
+			release_pages(gup[i].pvec, gup[i].pinned);
+	}
+
+	kfree(gup);
+	return err;
+}
+
 static void
 __i915_gem_userptr_get_pages_worker(struct work_struct *_work)
 {
@@ -494,24 +911,10 @@ __i915_gem_userptr_get_pages_worker(struct work_struct *_work)
 
 		ret = -EFAULT;
 		if (mmget_not_zero(mm)) {
-			down_read(&mm->mmap_sem);
-			while (pinned < npages) {
-				ret = get_user_pages_remote
-					(work->task, mm,
-					 obj->userptr.ptr + pinned * PAGE_SIZE,
-					 npages - pinned,
-					 flags,
-#ifdef __linux__
-					 pvec + pinned, NULL, NULL);
-#elif defined(__FreeBSD__)
-					 pvec + pinned, NULL);
-#endif
-				if (ret < 0)
-					break;
-
-				pinned += ret;
-			}
-			up_read(&mm->mmap_sem);
+			ret = userptr_gup(work->task, mm, obj->userptr.ptr,
+					  npages, flags, pvec);
+			if (ret == 0)
+				pinned = npages;
 			mmput(mm);
 		}
 	}
@@ -618,7 +1021,19 @@ static int i915_gem_userptr_get_pages(struct drm_i915_gem_object *obj)
 			return -EAGAIN;
 	}
 
-	pvec = NULL;
+	/* Reuse the pages of a freed object covering the same range */
+	pvec = i915_mmu_pages_take(obj);
+	if (pvec) {
+		pages = __i915_gem_userptr_alloc_pages(obj, pvec, num_pages);
+		if (IS_ERR(pages)) {
+			__i915_gem_userptr_set_active(obj, false);
+			release_pages(pvec, num_pages);
+		}
+		kvfree(pvec);
+
+		return PTR_ERR_OR_ZERO(pages);
+	}
+
 	pinned = 0;
 
 	if (mm == current->mm) {
@@ -660,10 +1075,13 @@ i915_gem_userptr_put_pages(struct drm_i915_gem_object *obj,
 {
 	struct sgt_iter sgt_iter;
 	struct page *page;
+	bool keep;
 
 	/* Cancel any inflight work and force them to restart their gup */
 	obj->userptr.work = NULL;
-	__i915_gem_userptr_set_active(obj, false);
+	keep = pages && i915_mmu_pages_stash(obj, pages);
+	if (!keep)
+		__i915_gem_userptr_set_active(obj, false);
 	if (!pages)
 		return;
 
@@ -703,7 +1121,8 @@ i915_gem_userptr_put_pages(struct drm_i915_gem_object *obj,
 		}
 
 		mark_page_accessed(page);
-		put_page(page);
+		if (!keep)
+			put_page(page);
 	}
 	obj->mm.dirty = false;
 
@@ -866,5 +1285,7 @@ int i915_gem_init_userptr(struct drm_i915_private *dev_priv)
 
 void i915_gem_cleanup_userptr(struct drm_i915_private *dev_priv)
 {
+	/* Release whatever freed objects left behind, before draining */
+	i915_gem_userptr_shrink(dev_priv);
 	destroy_workqueue(dev_priv->mm.userptr_wq);
 }
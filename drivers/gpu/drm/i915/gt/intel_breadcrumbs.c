@@ -137,10 +137,10 @@ __dma_fence_signal__notify(struct dma_fence *fence,
 void intel_engine_breadcrumbs_irq(struct intel_engine_cs *engine)
 {
 	struct intel_breadcrumbs *b = &engine->breadcrumbs;
-	const ktime_t timestamp = ktime_get();
 	struct intel_context *ce, *cn;
 	struct list_head *pos, *next;
 	LIST_HEAD(signal);
+	ktime_t timestamp;
 
 	spin_lock(&b->irq_lock);
 
@@ -190,6 +190,15 @@ void intel_engine_breadcrumbs_irq(struct intel_engine_cs *engine)
 
 	spin_unlock(&b->irq_lock);
 
+	/*
+	 * Most interrupts find nothing to signal (the waiters are for later
+	 * requests), so only read the clock once we know we need it. All of
+	 * this batch is then stamped with the same time.
+	 */
+	if (list_empty(&signal))
+		return;
+
+	timestamp = ktime_get();
 	list_for_each_safe(pos, next, &signal) {
 		struct i915_request *rq =
 			list_entry(pos, typeof(*rq), signal_link);
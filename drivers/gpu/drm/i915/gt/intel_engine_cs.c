@@ -476,6 +476,7 @@ cleanup:
 void intel_engine_init_execlists(struct intel_engine_cs *engine)
 {
 	struct intel_engine_execlists * const execlists = &engine->execlists;
+	int i;
 
 	execlists->port_mask = 1;
 	GEM_BUG_ON(!is_power_of_2(execlists_num_ports(execlists)));
@@ -487,6 +488,10 @@ void intel_engine_init_execlists(struct intel_engine_cs *engine)
 
 	execlists->queue_priority_hint = INT_MIN;
 	execlists->queue = RB_ROOT_CACHED;
+
+	RB_CLEAR_NODE(&execlists->default_priolist.node);
+	for (i = 0; i < ARRAY_SIZE(execlists->fixed_priolist); i++)
+		RB_CLEAR_NODE(&execlists->fixed_priolist[i].node);
 }
 
 static void cleanup_status_page(struct intel_engine_cs *engine)
@@ -714,6 +719,9 @@ intel_engine_init_active(struct intel_engine_cs *engine, unsigned int subclass)
 	spin_lock_init(&engine->active.lock);
 	lockdep_set_subclass(&engine->active.lock, subclass);
 
+	spin_lock_init(&engine->request_cache.lock);
+	engine->request_cache.count = 0;
+
 	/*
 	 * Due to an interesting quirk in lockdep's internal debug tracking,
 	 * after setting a subclass we must ensure the lock is used. Otherwise,
@@ -810,6 +818,7 @@ void intel_engine_cleanup_common(struct intel_engine_cs *engine)
 	intel_engine_pool_fini(&engine->pool);
 	intel_engine_fini_breadcrumbs(engine);
 	intel_engine_cleanup_cmd_parser(engine);
+	i915_request_cache_fini(engine);
 
 	if (engine->default_state)
 		i915_gem_object_put(engine->default_state);
@@ -39,6 +39,50 @@ static void node_free(struct intel_engine_pool_node *node)
 	kfree(node);
 }
 
+/*
+ * Free the nodes that have sat idle in the pool for at least @old jiffies.
+ * Each bucket is kept in most recently used order, so stop at the first
+ * younger node. Returns true if nodes are left in the pool.
+ */
+static bool pool_free_older_than(struct intel_engine_pool *pool, long old)
+{
+	struct intel_engine_pool_node *node, *nn;
+	unsigned long flags;
+	bool active = false;
+	LIST_HEAD(stale);
+	int n;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	for (n = 0; n < ARRAY_SIZE(pool->cache_list); n++) {
+		struct list_head *list = &pool->cache_list[n];
+
+		list_for_each_entry_safe_reverse(node, nn, list, link) {
+			if (time_before(jiffies, node->age + old))
+				break;
+
+			list_move(&node->link, &stale);
+		}
+
+		active |= !list_empty(list);
+	}
+	spin_unlock_irqrestore(&pool->lock, flags);
+
+	list_for_each_entry_safe(node, nn, &stale, link)
+		node_free(node);
+
+	return active;
+}
+
+static void pool_free_work(struct work_struct *wrk)
+{
+	struct intel_engine_pool *pool =
+		container_of(wrk, typeof(*pool), work.work);
+
+	if (pool_free_older_than(pool, HZ))
+		schedule_delayed_work(&pool->work,
+				      round_jiffies_up_relative(HZ));
+}
+
 static int pool_active(struct i915_active *ref)
 {
 	struct intel_engine_pool_node *node =
@@ -73,12 +117,20 @@ static void pool_retire(struct i915_active *ref)
 
 	i915_gem_object_unpin_pages(node->obj);
 
-	/* Return this object to the shrinker pool */
+	/*
+	 * Return this object to the shrinker pool. Its pages and mapping
+	 * are kept for the next batch of this size class, unless the
+	 * shrinker needs them first or it idles for too long.
+	 */
 	i915_gem_object_make_purgeable(node->obj);
 
 	spin_lock_irqsave(&pool->lock, flags);
+	node->age = jiffies;
 	list_add(&node->link, list);
 	spin_unlock_irqrestore(&pool->lock, flags);
+
+	schedule_delayed_work(&pool->work,
+			      round_jiffies_up_relative(HZ));
 }
 
 static struct intel_engine_pool_node *
@@ -153,27 +205,28 @@ void intel_engine_pool_init(struct intel_engine_pool *pool)
 	spin_lock_init(&pool->lock);
 	for (n = 0; n < ARRAY_SIZE(pool->cache_list); n++)
 		INIT_LIST_HEAD(&pool->cache_list[n]);
+
+	INIT_DELAYED_WORK(&pool->work, pool_free_work);
 }
 
 void intel_engine_pool_park(struct intel_engine_pool *pool)
 {
-	int n;
-
-	for (n = 0; n < ARRAY_SIZE(pool->cache_list); n++) {
-		struct list_head *list = &pool->cache_list[n];
-		struct intel_engine_pool_node *node, *nn;
-
-		list_for_each_entry_safe(node, nn, list, link)
-			node_free(node);
-
-		INIT_LIST_HEAD(list);
-	}
+	/*
+	 * Keep recently used buffers across short idle periods, the
+	 * worker releases the rest once they have been unused for a while.
+	 */
+	if (pool_free_older_than(pool, HZ))
+		schedule_delayed_work(&pool->work,
+				      round_jiffies_up_relative(HZ));
 }
 
 void intel_engine_pool_fini(struct intel_engine_pool *pool)
 {
 	int n;
 
+	cancel_delayed_work_sync(&pool->work);
+	pool_free_older_than(pool, 0);
+
 	for (n = 0; n < ARRAY_SIZE(pool->cache_list); n++)
 		GEM_BUG_ON(!list_empty(&pool->cache_list[n]));
 }
@@ -9,6 +9,7 @@
 
 #include <linux/list.h>
 #include <linux/spinlock.h>
+#include <linux/workqueue.h>
 
 #include "i915_active_types.h"
 
@@ -17,6 +18,7 @@ struct drm_i915_gem_object;
 struct intel_engine_pool {
 	spinlock_t lock;
 	struct list_head cache_list[4];
+	struct delayed_work work;
 };
 
 struct intel_engine_pool_node {
@@ -24,6 +26,7 @@ struct intel_engine_pool_node {
 	struct drm_i915_gem_object *obj;
 	struct list_head link;
 	struct intel_engine_pool *pool;
+	unsigned long age;
 };
 
 #endif /* INTEL_ENGINE_POOL_TYPES_H */
@@ -12,6 +12,7 @@
 #include <linux/kref.h>
 #include <linux/list.h>
 #include <linux/llist.h>
+#include <linux/mutex.h>
 #include <linux/rbtree.h>
 #include <linux/timer.h>
 #include <linux/types.h>
@@ -54,7 +55,8 @@
 #define I915_MAX_SLICES	3
 #define I915_MAX_SUBSLICES 8
 
-#define I915_CMD_HASH_ORDER 9
+#define I915_CMD_CLIENT_COUNT 8
+#define I915_CMD_CACHE_ORDER 4
 
 struct dma_fence;
 struct drm_i915_gem_object;
@@ -183,6 +185,11 @@ struct intel_engine_execlists {
 	 */
 	struct i915_priolist default_priolist;
 
+	/**
+	 * @fixed_priolist: priority lists for the other common priorities
+	 */
+	struct i915_priolist fixed_priolist[I915_PRIOLIST_FIXED];
+
 	/**
 	 * @no_priolist: priority lists disabled
 	 */
@@ -322,6 +329,17 @@ struct intel_engine_cs {
 		struct list_head requests;
 	} active;
 
+	/*
+	 * A few recently freed requests, handed straight to the next request
+	 * created on this engine rather than bouncing through the slab.
+	 */
+	struct {
+		spinlock_t lock;
+		unsigned int count;
+#define I915_ENGINE_REQUEST_CACHE 16
+		struct i915_request *free[I915_ENGINE_REQUEST_CACHE];
+	} request_cache;
+
 	struct llist_head barrier_tasks;
 
 	struct intel_context *kernel_context; /* pinned */
@@ -491,9 +509,22 @@ struct intel_engine_cs {
 
 	/*
 	 * Table of commands the command parser needs to know about
-	 * for this engine.
+	 * for this engine, indexed by the client and then by the opcode
+	 * bits of the command header.
 	 */
-	DECLARE_HASHTABLE(cmd_hash, I915_CMD_HASH_ORDER);
+	struct hlist_head *cmd_table[I915_CMD_CLIENT_COUNT];
+
+	/*
+	 * Small LRU of batch contents that have already passed the command
+	 * parser on this engine, so that identical resubmissions can skip
+	 * the per-command validation.
+	 */
+	struct {
+		struct mutex lock;
+		struct list_head lru;
+		DECLARE_HASHTABLE(hash, I915_CMD_CACHE_ORDER);
+		unsigned int count;
+	} cmd_cache;
 
 	/*
 	 * Table of registers allowed in commands that read/write registers.
@@ -501,6 +532,14 @@ struct intel_engine_cs {
 	const struct drm_i915_reg_table *reg_tables;
 	int reg_table_count;
 
+	/*
+	 * Bitmaps, indexed by dword offset, of the registers in reg_tables
+	 * and of those which also restrict the value that may be written.
+	 */
+	unsigned long *reg_bitmap;
+	unsigned long *reg_masked;
+	u32 reg_bitmap_count;
+
 	/*
 	 * Returns the bitmask for the length field of the specified command.
 	 * Return 0 for an unrecognized/invalid command.
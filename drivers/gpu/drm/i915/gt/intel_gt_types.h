@@ -47,6 +47,7 @@ struct intel_gt {
 		/* Pack multiple timelines' seqnos into the same page */
 		spinlock_t hwsp_lock;
 		struct list_head hwsp_free_list;
+		unsigned int hwsp_idle; /* unused HWSP kept on the freelist */
 	} timelines;
 
 	struct intel_wakeref wakeref;
@@ -54,6 +55,8 @@ struct intel_gt {
 	struct list_head closed_vma;
 	spinlock_t closed_lock; /* guards the list of closed_vma */
 
+	spinlock_t schedule_lock; /* guards the request dependency graph */
+
 	struct intel_hangcheck hangcheck;
 	struct intel_reset reset;
 
@@ -1629,6 +1629,20 @@ static void __execlists_submission_tasklet(struct intel_engine_cs *const engine)
 	}
 }
 
+static inline bool csb_pending(const struct intel_engine_execlists *execlists)
+{
+	return (u8)READ_ONCE(*execlists->csb_write) != execlists->csb_head;
+}
+
+/*
+ * Under a heavy submission load the HW keeps writing new context-switch
+ * events while we are busy dequeuing. Rather than bounce through another
+ * interrupt and tasklet invocation for each of those, pick them up (and
+ * refill the ELSP in response) in the same pass, but only for a few rounds
+ * so that we do not hog the softirq.
+ */
+#define EXECLISTS_CSB_ROUNDS 4
+
 /*
  * Check the unread Context Status Buffers and manage the submission of new
  * contexts to the ELSP accordingly.
@@ -1636,14 +1650,19 @@ static void __execlists_submission_tasklet(struct intel_engine_cs *const engine)
 static void execlists_submission_tasklet(unsigned long data)
 {
 	struct intel_engine_cs * const engine = (struct intel_engine_cs *)data;
+	struct intel_engine_execlists * const execlists = &engine->execlists;
+	unsigned int rounds = EXECLISTS_CSB_ROUNDS;
 	unsigned long flags;
 
-	process_csb(engine);
-	if (!READ_ONCE(engine->execlists.pending[0])) {
+	do {
+		process_csb(engine);
+		if (READ_ONCE(execlists->pending[0]))
+			break;
+
 		spin_lock_irqsave(&engine->active.lock, flags);
 		__execlists_submission_tasklet(engine);
 		spin_unlock_irqrestore(&engine->active.lock, flags);
-	}
+	} while (--rounds && csb_pending(execlists));
 }
 
 static void execlists_submission_timer(struct timer_list *timer)
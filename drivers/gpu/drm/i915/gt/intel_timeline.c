@@ -86,9 +86,12 @@ hwsp_alloc(struct intel_timeline *timeline, unsigned int *cacheline)
 
 		spin_lock_irq(&gt->hwsp_lock);
 		list_add(&hwsp->free_link, &gt->hwsp_free_list);
+		gt->hwsp_idle++;
 	}
 
 	GEM_BUG_ON(!hwsp->free_bitmap);
+	if (hwsp->free_bitmap == ~0ull)
+		gt->hwsp_idle--;
 #ifdef __linux__
 	*cacheline = __ffs64(hwsp->free_bitmap);
 #elif defined(__FreeBSD__)
@@ -118,11 +121,20 @@ static void __idle_hwsp_free(struct intel_timeline_hwsp *hwsp, int cacheline)
 	GEM_BUG_ON(cacheline >= BITS_PER_TYPE(hwsp->free_bitmap));
 	hwsp->free_bitmap |= BIT_ULL(cacheline);
 
-	/* And if no one is left using it, give the page back to the system */
+	/*
+	 * And if no one is left using it, give the page back to the system.
+	 * Contexts (and so timelines) tend to be created and destroyed in
+	 * bursts, so hang on to one unused page to save reallocating it for
+	 * the next timeline.
+	 */
 	if (hwsp->free_bitmap == ~0ull) {
-		i915_vma_put(hwsp->vma);
-		list_del(&hwsp->free_link);
-		kfree(hwsp);
+		if (!gt->hwsp_idle) {
+			gt->hwsp_idle++;
+		} else {
+			i915_vma_put(hwsp->vma);
+			list_del(&hwsp->free_link);
+			kfree(hwsp);
+		}
 	}
 
 	spin_unlock_irqrestore(&gt->hwsp_lock, flags);
@@ -275,6 +287,7 @@ static void timelines_init(struct intel_gt *gt)
 
 	spin_lock_init(&timelines->hwsp_lock);
 	INIT_LIST_HEAD(&timelines->hwsp_free_list);
+	timelines->hwsp_idle = 0;
 }
 
 void intel_timelines_init(struct drm_i915_private *i915)
@@ -551,9 +564,19 @@ void __intel_timeline_free(struct kref *kref)
 static void timelines_fini(struct intel_gt *gt)
 {
 	struct intel_gt_timelines *timelines = &gt->timelines;
+	struct intel_timeline_hwsp *hwsp, *hn;
 
 	GEM_BUG_ON(!list_empty(&timelines->active_list));
-	GEM_BUG_ON(!list_empty(&timelines->hwsp_free_list));
+
+	/* Only the unused HWSP we kept around may remain */
+	list_for_each_entry_safe(hwsp, hn,
+				 &timelines->hwsp_free_list, free_link) {
+		GEM_BUG_ON(hwsp->free_bitmap != ~0ull);
+		i915_vma_put(hwsp->vma);
+		kfree(hwsp);
+	}
+	INIT_LIST_HEAD(&timelines->hwsp_free_list);
+	timelines->hwsp_idle = 0;
 }
 
 void intel_timelines_fini(struct drm_i915_private *i915)
@@ -326,6 +326,7 @@ void mock_engine_free(struct intel_engine_cs *engine)
 	intel_context_put(engine->kernel_context);
 
 	intel_engine_fini_breadcrumbs(engine);
+	i915_request_cache_fini(engine);
 
 	kfree(engine);
 }
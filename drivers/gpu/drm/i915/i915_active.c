@@ -140,7 +140,7 @@ __active_retire(struct i915_active *ref)
 		debug_active_deactivate(ref);
 		root = ref->tree;
 		ref->tree = RB_ROOT;
-		ref->cache = NULL;
+		memset(ref->cache, 0, sizeof(ref->cache));
 		retire = true;
 	}
 
@@ -176,6 +176,51 @@ node_retire(struct i915_active_request *base, struct i915_request *rq)
 	active_retire(node_from_active(base)->ref);
 }
 
+static struct active_node *
+cache_lookup(struct i915_active *ref, u64 idx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(ref->cache); i++) {
+		struct active_node *node = READ_ONCE(ref->cache[i]);
+
+		if (node && node->timeline == idx)
+			return node;
+	}
+
+	return NULL;
+}
+
+static void cache_insert(struct i915_active *ref, struct active_node *node)
+{
+	int i;
+
+	lockdep_assert_held(&ref->mutex);
+
+	/*
+	 * Move the node to the front, the others shuffle down in order of
+	 * use. Lockless readers may briefly see a node twice, or miss it and
+	 * fall back to the rbtree, either of which is harmless.
+	 */
+	for (i = 0; i < ARRAY_SIZE(ref->cache) - 1; i++)
+		if (ref->cache[i] == node)
+			break;
+	for (; i > 0; i--)
+		WRITE_ONCE(ref->cache[i], ref->cache[i - 1]);
+	WRITE_ONCE(ref->cache[0], node);
+}
+
+static void cache_remove(struct i915_active *ref, struct active_node *node)
+{
+	int i;
+
+	lockdep_assert_held(&ref->mutex);
+
+	for (i = 0; i < ARRAY_SIZE(ref->cache); i++)
+		if (ref->cache[i] == node)
+			WRITE_ONCE(ref->cache[i], NULL);
+}
+
 static struct i915_active_request *
 active_instance(struct i915_active *ref, struct intel_timeline *tl)
 {
@@ -184,14 +229,13 @@ active_instance(struct i915_active *ref, struct intel_timeline *tl)
 	u64 idx = tl->fence_context;
 
 	/*
-	 * We track the most recently used timeline to skip a rbtree search
-	 * for the common case, under typical loads we never need the rbtree
-	 * at all. We can reuse the last slot if it is empty, that is
-	 * after the previous activity has been retired, or if it matches the
-	 * current timeline.
+	 * We track the few most recently used timelines to skip a rbtree
+	 * search for the common case, under typical loads we never need the
+	 * rbtree (nor the mutex) at all. The nodes remain valid until the
+	 * final retirement, which cannot happen while we are active.
 	 */
-	node = READ_ONCE(ref->cache);
-	if (node && node->timeline == idx)
+	node = cache_lookup(ref, idx);
+	if (node)
 		return &node->base;
 
 	/* Preallocate a replacement, just in case */
@@ -228,7 +272,7 @@ active_instance(struct i915_active *ref, struct intel_timeline *tl)
 	rb_insert_color(&node->node, &ref->tree);
 
 out:
-	ref->cache = node;
+	cache_insert(ref, node);
 	mutex_unlock(&ref->mutex);
 
 	BUILD_BUG_ON(offsetof(typeof(*node), base));
@@ -248,7 +292,7 @@ void __i915_active_init(struct drm_i915_private *i915,
 	ref->active = active;
 	ref->retire = retire;
 	ref->tree = RB_ROOT;
-	ref->cache = NULL;
+	memset(ref->cache, 0, sizeof(ref->cache));
 	init_llist_head(&ref->preallocated_barriers);
 	atomic_set(&ref->count, 0);
 	__mutex_init(&ref->mutex, "i915_active", key);
@@ -503,6 +547,7 @@ static inline bool is_idle_barrier(struct active_node *node, u64 idx)
 static struct active_node *reuse_idle_barrier(struct i915_active *ref, u64 idx)
 {
 	struct rb_node *prev, *p;
+	int i;
 
 	if (RB_EMPTY_ROOT(&ref->tree))
 		return NULL;
@@ -517,9 +562,13 @@ static struct active_node *reuse_idle_barrier(struct i915_active *ref, u64 idx)
 	 * completely idle barriers (less hassle in manipulating the llists),
 	 * but otherwise any will do.
 	 */
-	if (ref->cache && is_idle_barrier(ref->cache, idx)) {
-		p = &ref->cache->node;
-		goto match;
+	for (i = 0; i < ARRAY_SIZE(ref->cache); i++) {
+		struct active_node *node = ref->cache[i];
+
+		if (node && is_idle_barrier(node, idx)) {
+			p = &node->node;
+			goto match;
+		}
 	}
 
 	prev = NULL;
@@ -578,8 +627,7 @@ static struct active_node *reuse_idle_barrier(struct i915_active *ref, u64 idx)
 
 match:
 	rb_erase(p, &ref->tree); /* Hide from waits and sibling allocations */
-	if (p == &ref->cache->node)
-		ref->cache = NULL;
+	cache_remove(ref, rb_entry(p, struct active_node, node));
 	mutex_unlock(&ref->mutex);
 
 	return rb_entry(p, struct active_node, node);
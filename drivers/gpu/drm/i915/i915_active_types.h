@@ -46,7 +46,9 @@ struct active_node;
 struct i915_active {
 	struct drm_i915_private *i915;
 
-	struct active_node *cache;
+	/* Most recently used nodes, checked without taking the mutex */
+#define I915_ACTIVE_CACHE 4
+	struct active_node *cache[I915_ACTIVE_CACHE];
 	struct rb_root tree;
 	struct mutex mutex;
 	atomic_t count;
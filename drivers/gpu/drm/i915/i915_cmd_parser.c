@@ -25,6 +25,8 @@
  *
  */
 
+#include <linux/jhash.h>
+
 #include "gt/intel_engine.h"
 
 #include "i915_drv.h"
@@ -866,31 +868,45 @@ struct cmd_node {
  * example, MI commands use bits 31:23 while 3D commands use bits 31:16. The
  * problem is that, for example, MI commands use bits 22:16 for other fields
  * such as GGTT vs PPGTT bits. If we include those bits in the mask then when
- * we mask a command from a batch it could hash to the wrong bucket due to
+ * we mask a command from a batch it could index the wrong slot due to
  * non-opcode bits being set. But if we don't include those bits, some 3D
- * commands may hash to the same bucket due to not including opcode bits that
- * make the command unique. For now, we will risk hashing to the same bucket.
+ * commands may share a slot due to not including opcode bits that make the
+ * command unique. For now, we will risk sharing slots.
+ *
+ * The commands are kept in a dense table per client, indexed by the opcode
+ * bits below the client field, so that finding a descriptor is two loads
+ * rather than a hash walk.
  */
-static inline u32 cmd_header_key(u32 x)
+static inline unsigned int cmd_client_shift(unsigned int client)
 {
-	switch (x >> INSTR_CLIENT_SHIFT) {
+	switch (client) {
 	default:
 	case INSTR_MI_CLIENT:
-		return x >> STD_MI_OPCODE_SHIFT;
+		return STD_MI_OPCODE_SHIFT;
 	case INSTR_RC_CLIENT:
-		return x >> STD_3D_OPCODE_SHIFT;
+		return STD_3D_OPCODE_SHIFT;
 	case INSTR_BC_CLIENT:
-		return x >> STD_2D_OPCODE_SHIFT;
+		return STD_2D_OPCODE_SHIFT;
 	}
 }
 
-static int init_hash_table(struct intel_engine_cs *engine,
-			   const struct drm_i915_cmd_table *cmd_tables,
-			   int cmd_table_count)
+static inline unsigned int cmd_client_size(unsigned int client)
 {
-	int i, j;
+	return BIT(INSTR_CLIENT_SHIFT - cmd_client_shift(client));
+}
 
-	hash_init(engine->cmd_hash);
+static inline u32 cmd_header_index(u32 x)
+{
+	const unsigned int client = x >> INSTR_CLIENT_SHIFT;
+
+	return (x >> cmd_client_shift(client)) & (cmd_client_size(client) - 1);
+}
+
+static int init_cmd_table(struct intel_engine_cs *engine,
+			  const struct drm_i915_cmd_table *cmd_tables,
+			  int cmd_table_count)
+{
+	int i, j;
 
 	for (i = 0; i < cmd_table_count; i++) {
 		const struct drm_i915_cmd_table *table = &cmd_tables[i];
@@ -898,33 +914,231 @@ static int init_hash_table(struct intel_engine_cs *engine,
 		for (j = 0; j < table->count; j++) {
 			const struct drm_i915_cmd_descriptor *desc =
 				&table->table[j];
-			struct cmd_node *desc_node =
-				kmalloc(sizeof(*desc_node), GFP_KERNEL);
+			const unsigned int client =
+				desc->cmd.value >> INSTR_CLIENT_SHIFT;
+			struct cmd_node *desc_node;
+			struct hlist_head *slot;
+
+			if (!engine->cmd_table[client]) {
+				engine->cmd_table[client] =
+					kcalloc(cmd_client_size(client),
+						sizeof(struct hlist_head),
+						GFP_KERNEL);
+				if (!engine->cmd_table[client])
+					return -ENOMEM;
+			}
 
+			desc_node = kmalloc(sizeof(*desc_node), GFP_KERNEL);
 			if (!desc_node)
 				return -ENOMEM;
 
 			desc_node->desc = desc;
-			hash_add(engine->cmd_hash, &desc_node->node,
-				 cmd_header_key(desc->cmd.value));
+			slot = &engine->cmd_table[client][cmd_header_index(desc->cmd.value)];
+			hlist_add_head(&desc_node->node, slot);
 		}
 	}
 
 	return 0;
 }
 
-static void fini_hash_table(struct intel_engine_cs *engine)
+static void fini_cmd_table(struct intel_engine_cs *engine)
 {
 	struct hlist_node *tmp;
 	struct cmd_node *desc_node;
-	int i;
+	unsigned int client, i;
+
+	for (client = 0; client < ARRAY_SIZE(engine->cmd_table); client++) {
+		struct hlist_head *table = engine->cmd_table[client];
+
+		if (!table)
+			continue;
+
+		for (i = 0; i < cmd_client_size(client); i++) {
+			hlist_for_each_entry_safe(desc_node, tmp,
+						  &table[i], node) {
+				hlist_del(&desc_node->node);
+				kfree(desc_node);
+			}
+		}
+
+		kfree(table);
+		engine->cmd_table[client] = NULL;
+	}
+}
+
+/*
+ * Flatten the register whitelist into a bitmap so that the common case of an
+ * allowed register without a value restriction is a single bit test. If the
+ * bitmap cannot be built we fall back to searching reg_tables.
+ */
+static void init_reg_bitmap(struct intel_engine_cs *engine)
+{
+	const struct drm_i915_reg_table *table;
+	unsigned long *bitmap;
+	u32 count = 0;
+	int i, j;
 
-	hash_for_each_safe(engine->cmd_hash, i, tmp, desc_node, node) {
-		hash_del(&desc_node->node);
-		kfree(desc_node);
+	for (i = 0; i < engine->reg_table_count; i++) {
+		table = &engine->reg_tables[i];
+
+		for (j = 0; j < table->num_regs; j++) {
+			u32 addr = i915_mmio_reg_offset(table->regs[j].addr);
+
+			if (addr & (sizeof(u32) - 1))
+				return;
+
+			count = max_t(u32, count, addr / sizeof(u32) + 1);
+		}
+	}
+
+	if (!count)
+		return;
+
+	bitmap = kcalloc(2 * BITS_TO_LONGS(count), sizeof(long), GFP_KERNEL);
+	if (!bitmap)
+		return;
+
+	engine->reg_bitmap = bitmap;
+	engine->reg_masked = bitmap + BITS_TO_LONGS(count);
+	engine->reg_bitmap_count = count;
+
+	for (i = 0; i < engine->reg_table_count; i++) {
+		table = &engine->reg_tables[i];
+
+		for (j = 0; j < table->num_regs; j++) {
+			const struct drm_i915_reg_descriptor *reg =
+				&table->regs[j];
+			u32 idx = i915_mmio_reg_offset(reg->addr) / sizeof(u32);
+
+			set_bit(idx, engine->reg_bitmap);
+			if (reg->mask)
+				set_bit(idx, engine->reg_masked);
+		}
 	}
 }
 
+static void fini_reg_bitmap(struct intel_engine_cs *engine)
+{
+	kfree(engine->reg_bitmap);
+	engine->reg_bitmap = NULL;
+	engine->reg_masked = NULL;
+	engine->reg_bitmap_count = 0;
+}
+
+/*
+ * Userspace tends to resubmit the same small batches (state setup, clears,
+ * blits) over and over again. Once a batch has been validated, remember its
+ * contents so that an identical copy can skip the command walk. Only batches
+ * that terminate with MI_BATCH_BUFFER_END are remembered: the result for a
+ * chained MI_BATCH_BUFFER_START depends on the batch and shadow addresses
+ * and on the jump whitelist, not just on the contents.
+ *
+ * The lookup compares the full contents of the shadow copy, so a hash
+ * collision can never let an unvalidated batch through, and userspace
+ * writing to the batch object after submission is harmless as we only ever
+ * look at the private copy.
+ */
+#define CMD_CACHE_MAX_ENTRIES 32
+#define CMD_CACHE_MAX_LEN SZ_16K
+
+struct cmd_cache_node {
+	struct hlist_node node;
+	struct list_head link;
+	u32 hash;
+	u32 len;
+	u32 end;
+	u32 cmds[];
+};
+
+static void init_cmd_cache(struct intel_engine_cs *engine)
+{
+	mutex_init(&engine->cmd_cache.lock);
+	INIT_LIST_HEAD(&engine->cmd_cache.lru);
+	hash_init(engine->cmd_cache.hash);
+	engine->cmd_cache.count = 0;
+}
+
+static void fini_cmd_cache(struct intel_engine_cs *engine)
+{
+	struct cmd_cache_node *cn, *next;
+
+	list_for_each_entry_safe(cn, next, &engine->cmd_cache.lru, link)
+		kfree(cn);
+	INIT_LIST_HEAD(&engine->cmd_cache.lru);
+	hash_init(engine->cmd_cache.hash);
+	engine->cmd_cache.count = 0;
+	mutex_destroy(&engine->cmd_cache.lock);
+}
+
+static u32 cmd_cache_hash(const u32 *cmds, u32 len)
+{
+	return jhash(cmds, len, 0);
+}
+
+/*
+ * Returns the offset (in dwords) of the MI_BATCH_BUFFER_END for a batch
+ * identical to one previously validated on this engine, or -1 if unknown.
+ */
+static long cmd_cache_lookup(struct intel_engine_cs *engine,
+			     const u32 *cmds, u32 len, u32 hash)
+{
+	struct cmd_cache_node *cn;
+	long end = -1;
+
+	if (len > CMD_CACHE_MAX_LEN)
+		return -1;
+
+	mutex_lock(&engine->cmd_cache.lock);
+	hash_for_each_possible(engine->cmd_cache.hash, cn, node, hash) {
+		if (cn->hash != hash || cn->len != len)
+			continue;
+
+		if (memcmp(cn->cmds, cmds, len))
+			continue;
+
+		list_move(&cn->link, &engine->cmd_cache.lru);
+		end = cn->end;
+		break;
+	}
+	mutex_unlock(&engine->cmd_cache.lock);
+
+	return end;
+}
+
+static void cmd_cache_insert(struct intel_engine_cs *engine,
+			     const u32 *cmds, u32 len, u32 hash, u32 end)
+{
+	struct cmd_cache_node *cn;
+
+	if (len > CMD_CACHE_MAX_LEN)
+		return;
+
+	cn = kmalloc(sizeof(*cn) + len, GFP_KERNEL | __GFP_NOWARN);
+	if (!cn)
+		return;
+
+	cn->hash = hash;
+	cn->len = len;
+	cn->end = end;
+	memcpy(cn->cmds, cmds, len);
+
+	mutex_lock(&engine->cmd_cache.lock);
+	if (engine->cmd_cache.count == CMD_CACHE_MAX_ENTRIES) {
+		struct cmd_cache_node *old =
+			list_last_entry(&engine->cmd_cache.lru,
+					typeof(*old), link);
+
+		hash_del(&old->node);
+		list_del(&old->link);
+		kfree(old);
+	} else {
+		engine->cmd_cache.count++;
+	}
+	hash_add(engine->cmd_cache.hash, &cn->node, hash);
+	list_add(&cn->link, &engine->cmd_cache.lru);
+	mutex_unlock(&engine->cmd_cache.lock);
+}
+
 /**
  * intel_engine_init_cmd_parser() - set cmd parser related fields for an engine
  * @engine: the engine to initialize
@@ -1019,13 +1233,16 @@ void intel_engine_init_cmd_parser(struct intel_engine_cs *engine)
 		return;
 	}
 
-	ret = init_hash_table(engine, cmd_tables, cmd_table_count);
+	ret = init_cmd_table(engine, cmd_tables, cmd_table_count);
 	if (ret) {
 		DRM_ERROR("%s: initialised failed!\n", engine->name);
-		fini_hash_table(engine);
+		fini_cmd_table(engine);
 		return;
 	}
 
+	init_reg_bitmap(engine);
+	init_cmd_cache(engine);
+
 	engine->flags |= I915_ENGINE_USING_CMD_PARSER;
 }
 
@@ -1041,17 +1258,23 @@ void intel_engine_cleanup_cmd_parser(struct intel_engine_cs *engine)
 	if (!intel_engine_using_cmd_parser(engine))
 		return;
 
-	fini_hash_table(engine);
+	fini_cmd_cache(engine);
+	fini_reg_bitmap(engine);
+	fini_cmd_table(engine);
 }
 
 static const struct drm_i915_cmd_descriptor*
 find_cmd_in_table(struct intel_engine_cs *engine,
 		  u32 cmd_header)
 {
+	struct hlist_head *table = engine->cmd_table[cmd_header >> INSTR_CLIENT_SHIFT];
 	struct cmd_node *desc_node;
 
-	hash_for_each_possible(engine->cmd_hash, desc_node, node,
-			       cmd_header_key(cmd_header)) {
+	if (!table)
+		return NULL;
+
+	hlist_for_each_entry(desc_node, &table[cmd_header_index(cmd_header)],
+			     node) {
 		const struct drm_i915_cmd_descriptor *desc = desc_node->desc;
 		if (((cmd_header ^ desc->cmd.value) & desc->cmd.mask) == 0)
 			return desc;
@@ -1124,6 +1347,35 @@ find_reg(const struct intel_engine_cs *engine, u32 addr)
 	return reg;
 }
 
+/*
+ * Returns NULL if addr is whitelisted without restriction, the whitelist
+ * entry if writes to it must also match a mask/value pair, or an error
+ * pointer if the register is not whitelisted at all.
+ */
+static const struct drm_i915_reg_descriptor *
+lookup_reg(const struct intel_engine_cs *engine, u32 addr)
+{
+	const struct drm_i915_reg_descriptor *reg;
+
+	if (engine->reg_bitmap) {
+		const u32 idx = addr / sizeof(u32);
+
+		if (addr & (sizeof(u32) - 1) ||
+		    idx >= engine->reg_bitmap_count ||
+		    !test_bit(idx, engine->reg_bitmap))
+			return ERR_PTR(-EACCES);
+
+		if (!test_bit(idx, engine->reg_masked))
+			return NULL;
+	}
+
+	reg = find_reg(engine, addr);
+	if (!reg)
+		return ERR_PTR(-EACCES);
+
+	return reg->mask ? reg : NULL;
+}
+
 /* Returns a vmap'd pointer to dst_obj, which the caller must unmap */
 static u32 *copy_batch(struct drm_i915_gem_object *dst_obj,
 		       struct drm_i915_gem_object *src_obj,
@@ -1228,9 +1480,9 @@ static bool check_cmd(const struct intel_engine_cs *engine,
 		     offset += step) {
 			const u32 reg_addr = cmd[offset] & desc->reg.mask;
 			const struct drm_i915_reg_descriptor *reg =
-				find_reg(engine, reg_addr);
+				lookup_reg(engine, reg_addr);
 
-			if (!reg) {
+			if (IS_ERR(reg)) {
 				DRM_DEBUG_DRIVER("CMD: Rejected register 0x%08X in command: 0x%08X (%s)\n",
 						 reg_addr, *cmd, engine->name);
 				return false;
@@ -1240,7 +1492,7 @@ static bool check_cmd(const struct intel_engine_cs *engine,
 			 * Check the value written to the register against the
 			 * allowed mask/value pair given in the whitelist entry.
 			 */
-			if (reg->mask) {
+			if (reg) {
 				if (desc->cmd.value == MI_LOAD_REGISTER_MEM) {
 					DRM_DEBUG_DRIVER("CMD: Rejected LRM to masked register 0x%08X\n",
 							 reg_addr);
@@ -1429,10 +1681,12 @@ int intel_engine_cmd_parser(struct i915_gem_context *ctx,
 			    struct drm_i915_gem_object *shadow_batch_obj,
 			    u64 shadow_batch_start)
 {
-	u32 *cmd, *batch_end, offset = 0;
+	u32 *cmd, *batch, *batch_end, offset = 0;
 	struct drm_i915_cmd_descriptor default_desc = noop_desc;
 	const struct drm_i915_cmd_descriptor *desc = &default_desc;
 	bool needs_clflush_after = false;
+	u32 hash = 0;
+	long end;
 	int ret = 0;
 
 	cmd = copy_batch(shadow_batch_obj, batch_obj,
@@ -1442,6 +1696,16 @@ int intel_engine_cmd_parser(struct i915_gem_context *ctx,
 		DRM_DEBUG_DRIVER("CMD: Failed to copy batch\n");
 		return PTR_ERR(cmd);
 	}
+	batch = cmd;
+
+	if (batch_len <= CMD_CACHE_MAX_LEN) {
+		hash = cmd_cache_hash(batch, batch_len);
+		end = cmd_cache_lookup(engine, batch, batch_len, hash);
+		if (end >= 0) {
+			cmd = batch + end;
+			goto done;
+		}
+	}
 
 	init_whitelist(ctx, batch_len);
 
@@ -1506,6 +1770,10 @@ int intel_engine_cmd_parser(struct i915_gem_context *ctx,
 		}
 	} while (1);
 
+	if (*cmd == MI_BATCH_BUFFER_END)
+		cmd_cache_insert(engine, batch, batch_len, hash, cmd - batch);
+
+done:
 	if (needs_clflush_after) {
 		void *ptr = page_mask_bits(shadow_batch_obj->mm.mapping);
 
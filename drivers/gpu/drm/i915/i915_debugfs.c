@@ -360,6 +360,13 @@ static int i915_gem_object_info(struct seq_file *m, void *data)
 		   i915->mm.shrink_count,
 		   atomic_read(&i915->mm.free_count),
 		   i915->mm.shrink_memory);
+	seq_printf(m, "%u parked objects, %llu bytes\n",
+		   i915->mm.shrink_parked_count,
+		   i915->mm.shrink_parked_memory);
+	seq_printf(m, "ppGTT bound with 2M pages: %lld bytes, 64K pages: %lld bytes, 4K pages: %lld bytes\n",
+		   (long long)atomic64_read(&i915->mm.gtt_page_size_bytes[I915_GTT_PAGE_SIZE_IDX_2M]),
+		   (long long)atomic64_read(&i915->mm.gtt_page_size_bytes[I915_GTT_PAGE_SIZE_IDX_64K]),
+		   (long long)atomic64_read(&i915->mm.gtt_page_size_bytes[I915_GTT_PAGE_SIZE_IDX_4K]));
 
 	seq_putc(m, '\n');
 
@@ -3935,6 +3942,35 @@ static void i915_print_sseu_info(struct seq_file *m, bool is_available_info,
 		   yesno(sseu->has_eu_pg));
 }
 
+static int i915_perf_info(struct seq_file *m, void *unused)
+{
+	struct drm_i915_private *dev_priv = node_to_i915(m->private);
+	struct i915_perf_stream *stream;
+
+	if (!dev_priv->perf.initialized)
+		return -ENODEV;
+
+	seq_printf(m, "OA buffer overflows: %lld\n",
+		   (long long)atomic64_read(&dev_priv->perf.oa_buffer_overflows));
+	seq_printf(m, "OA reports lost: %lld\n",
+		   (long long)atomic64_read(&dev_priv->perf.oa_reports_lost));
+
+	mutex_lock(&dev_priv->perf.lock);
+	stream = dev_priv->perf.exclusive_stream;
+	if (stream && stream->periodic) {
+		seq_printf(m, "OA period exponent: %d\n",
+			   stream->period_exponent);
+		seq_printf(m, "Poll period: %lluus [%llu, %llu]\n",
+			   div_u64(READ_ONCE(stream->poll_oa_period),
+				   NSEC_PER_USEC),
+			   div_u64(stream->poll_oa_period_min, NSEC_PER_USEC),
+			   div_u64(stream->poll_oa_period_max, NSEC_PER_USEC));
+	}
+	mutex_unlock(&dev_priv->perf.lock);
+
+	return 0;
+}
+
 static int i915_sseu_status(struct seq_file *m, void *unused)
 {
 	struct drm_i915_private *dev_priv = node_to_i915(m->private);
@@ -4332,6 +4368,7 @@ static const struct drm_info_list i915_debugfs_list[] = {
 	{"i915_sseu_status", i915_sseu_status, 0},
 	{"i915_drrs_status", i915_drrs_status, 0},
 	{"i915_rps_boost_info", i915_rps_boost_info, 0},
+	{"i915_perf_info", i915_perf_info, 0},
 };
 #define I915_DEBUGFS_ENTRIES ARRAY_SIZE(i915_debugfs_list)
 
@@ -669,6 +669,13 @@ struct i915_gem_mm {
 	 */
 	struct list_head shrink_list;
 
+	/**
+	 * List of shrinkable objects that the shrinker found pinned. They
+	 * are skipped until the shrinker runs out of other objects to try.
+	 */
+	struct list_head shrink_parked;
+	unsigned long shrink_unpark_time;
+
 	/**
 	 * List of objects which are pending destruction.
 	 */
@@ -709,6 +716,14 @@ struct i915_gem_mm {
 	/* shrinker accounting, also useful for userland debugging */
 	u64 shrink_memory;
 	u32 shrink_count;
+	u64 shrink_parked_memory;
+	u32 shrink_parked_count;
+
+	/* pages kept pinned by the userptr cache of freed objects */
+	atomic_long_t userptr_cache_pages;
+
+	/* bytes currently bound into a ppGTT, by largest GTT page size used */
+	atomic64_t gtt_page_size_bytes[I915_GTT_PAGE_SIZE_IDX_COUNT];
 };
 
 #define I915_IDLE_ENGINES_TIMEOUT (200) /* in ms */
@@ -1149,6 +1164,16 @@ struct i915_perf_stream {
 	wait_queue_head_t poll_wq;
 	bool pollin;
 
+	/**
+	 * The interval at which @poll_check_timer currently fires, adapted
+	 * within [@poll_oa_period_min, @poll_oa_period_max] to how far the
+	 * OA tail moved since @poll_oa_tail was sampled on the previous tick.
+	 */
+	u64 poll_oa_period;
+	u64 poll_oa_period_min;
+	u64 poll_oa_period_max;
+	u32 poll_oa_tail;
+
 	bool periodic;
 	int period_exponent;
 
@@ -1175,7 +1200,7 @@ struct i915_perf_stream {
 		 *
 		 * Note: Contention/performance aren't currently a significant
 		 * concern here considering the relatively low frequency of
-		 * hrtimer callbacks (5ms period) and that reads typically only
+		 * hrtimer callbacks (1-100ms period) and that reads typically only
 		 * happen in response to a hrtimer event and likely complete
 		 * before the next callback.
 		 *
@@ -1216,6 +1241,12 @@ struct i915_perf_stream {
 		 * OA buffer data to userspace.
 		 */
 		u32 head;
+
+		/**
+		 * The hardware tail as last read by oa_buffer_check_unlocked(),
+		 * used to adapt the poll period to the rate of new reports
+		 */
+		u32 hw_tail;
 	} oa_buffer;
 };
 
@@ -1700,6 +1731,14 @@ struct drm_i915_private {
 
 		struct i915_oa_config test_config;
 
+		/**
+		 * Number of times the OA buffer overflowed and had to be
+		 * reset, and number of times the OA unit reported dropping
+		 * reports, since the driver was loaded.
+		 */
+		atomic64_t oa_buffer_overflows;
+		atomic64_t oa_reports_lost;
+
 		u32 gen7_latched_oastatus1;
 		u32 ctx_oactxctrl_offset;
 		u32 ctx_flexeu0_offset;
@@ -2271,6 +2310,7 @@ int i915_getparam_ioctl(struct drm_device *dev, void *data,
 /* i915_gem.c */
 int i915_gem_init_userptr(struct drm_i915_private *dev_priv);
 void i915_gem_cleanup_userptr(struct drm_i915_private *dev_priv);
+void i915_gem_userptr_shrink(struct drm_i915_private *dev_priv);
 void i915_gem_sanitize(struct drm_i915_private *i915);
 int i915_gem_init_early(struct drm_i915_private *dev_priv);
 void i915_gem_cleanup_early(struct drm_i915_private *dev_priv);
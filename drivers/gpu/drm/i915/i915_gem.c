@@ -1114,6 +1114,7 @@ i915_gem_madvise_ioctl(struct drm_device *dev, void *data,
 				list = &i915->mm.purge_list;
 			else
 				list = &i915->mm.shrink_list;
+			__i915_gem_object_unpark(obj);
 			list_move_tail(&obj->mm.link, list);
 
 			spin_unlock_irqrestore(&i915->mm.obj_lock, flags);
@@ -1656,6 +1657,7 @@ static void i915_gem_init__mm(struct drm_i915_private *i915)
 
 	INIT_LIST_HEAD(&i915->mm.purge_list);
 	INIT_LIST_HEAD(&i915->mm.shrink_list);
+	INIT_LIST_HEAD(&i915->mm.shrink_parked);
 
 	i915_gem_init__objects(i915);
 }
@@ -566,6 +566,7 @@ static void i915_address_space_init(struct i915_address_space *vm, int subclass)
 	vm->mm.head_node.color = I915_COLOR_UNEVICTABLE;
 
 	stash_init(&vm->free_pages);
+	spin_lock_init(&vm->pt_cache.lock);
 
 	INIT_LIST_HEAD(&vm->unbound_list);
 	INIT_LIST_HEAD(&vm->bound_list);
@@ -936,6 +937,85 @@ gen8_pdp_for_page_address(struct i915_address_space * const vm, const u64 addr)
 	return gen8_pdp_for_page_index(vm, addr >> GEN8_PTE_SHIFT);
 }
 
+/*
+ * Clients tend to bind and unbind the same ranges over and over, so rather
+ * than freeing (and later reallocating, mapping and filling) the page tables
+ * as soon as a range empties, keep a few of them around on the vm. A table
+ * released because all of its entries were cleared holds nothing but scratch
+ * and can be reused without filling it again.
+ */
+static struct i915_page_table *
+gen8_alloc_pt(struct i915_address_space *vm, bool *clean)
+{
+	struct i915_page_table *pt = NULL;
+
+	spin_lock(&vm->pt_cache.lock);
+	if (vm->pt_cache.nclean) {
+		pt = vm->pt_cache.clean[--vm->pt_cache.nclean];
+		*clean = true;
+	} else if (vm->pt_cache.ndirty) {
+		pt = vm->pt_cache.dirty[--vm->pt_cache.ndirty];
+	}
+	spin_unlock(&vm->pt_cache.lock);
+
+	if (!pt)
+		return alloc_pt(vm);
+
+	atomic_set(&pt->used, 0);
+	return pt;
+}
+
+static struct i915_page_directory *gen8_alloc_pd(struct i915_address_space *vm)
+{
+	struct i915_page_directory *pd = NULL;
+
+	spin_lock(&vm->pt_cache.lock);
+	if (vm->pt_cache.npd)
+		pd = vm->pt_cache.pd[--vm->pt_cache.npd];
+	spin_unlock(&vm->pt_cache.lock);
+
+	if (!pd)
+		return alloc_pd(vm);
+
+	atomic_set(px_used(pd), 0);
+	memset(pd->entry, 0, sizeof(pd->entry));
+	return pd;
+}
+
+static void gen8_free_px(struct i915_address_space *vm,
+			 struct i915_page_table *pt,
+			 int lvl, bool clean)
+{
+	spin_lock(&vm->pt_cache.lock);
+	if (lvl) {
+		if (vm->pt_cache.npd < ARRAY_SIZE(vm->pt_cache.pd)) {
+			vm->pt_cache.pd[vm->pt_cache.npd++] = as_pd(pt);
+			pt = NULL;
+		}
+	} else if (clean &&
+		   vm->pt_cache.nclean < ARRAY_SIZE(vm->pt_cache.clean)) {
+		vm->pt_cache.clean[vm->pt_cache.nclean++] = pt;
+		pt = NULL;
+	} else if (vm->pt_cache.ndirty < ARRAY_SIZE(vm->pt_cache.dirty)) {
+		vm->pt_cache.dirty[vm->pt_cache.ndirty++] = pt;
+		pt = NULL;
+	}
+	spin_unlock(&vm->pt_cache.lock);
+
+	if (pt)
+		free_px(vm, pt);
+}
+
+static void gen8_pt_cache_fini(struct i915_address_space *vm)
+{
+	while (vm->pt_cache.nclean)
+		free_px(vm, vm->pt_cache.clean[--vm->pt_cache.nclean]);
+	while (vm->pt_cache.ndirty)
+		free_px(vm, vm->pt_cache.dirty[--vm->pt_cache.ndirty]);
+	while (vm->pt_cache.npd)
+		free_px(vm, vm->pt_cache.pd[--vm->pt_cache.npd]);
+}
+
 static void __gen8_ppgtt_cleanup(struct i915_address_space *vm,
 				 struct i915_page_directory *pd,
 				 int count, int lvl)
@@ -951,7 +1031,11 @@ static void __gen8_ppgtt_cleanup(struct i915_address_space *vm,
 		} while (pde++, --count);
 	}
 
-	free_px(vm, pd);
+	/* The top level is sized to the vm, the others can be reused */
+	if (lvl == vm->top)
+		free_px(vm, pd);
+	else
+		gen8_free_px(vm, &pd->pt, lvl, false);
 }
 
 static void gen8_ppgtt_cleanup(struct i915_address_space *vm)
@@ -962,6 +1046,7 @@ static void gen8_ppgtt_cleanup(struct i915_address_space *vm)
 		gen8_ppgtt_notify_vgt(ppgtt, false);
 
 	__gen8_ppgtt_cleanup(vm, ppgtt->pd, gen8_pd_top_count(vm), vm->top);
+	gen8_pt_cache_fini(vm);
 	free_scratch(vm);
 }
 
@@ -1018,7 +1103,7 @@ static u64 __gen8_ppgtt_clear(struct i915_address_space * const vm,
 		}
 
 		if (release_pd_entry(pd, idx, pt, scratch))
-			free_px(vm, pt);
+			gen8_free_px(vm, pt, lvl, true);
 	} while (idx++, --len);
 
 	return start;
@@ -1070,7 +1155,7 @@ static int __gen8_ppgtt_alloc(struct i915_address_space * const vm,
 			pt = fetch_and_zero(&alloc);
 			if (lvl) {
 				if (!pt) {
-					pt = &alloc_pd(vm)->pt;
+					pt = &gen8_alloc_pd(vm)->pt;
 					if (IS_ERR(pt)) {
 						ret = PTR_ERR(pt);
 						goto out;
@@ -1079,8 +1164,10 @@ static int __gen8_ppgtt_alloc(struct i915_address_space * const vm,
 
 				fill_px(pt, vm->scratch[lvl].encode);
 			} else {
+				bool clean = false;
+
 				if (!pt) {
-					pt = alloc_pt(vm);
+					pt = gen8_alloc_pt(vm, &clean);
 					if (IS_ERR(pt)) {
 						ret = PTR_ERR(pt);
 						goto out;
@@ -1088,7 +1175,8 @@ static int __gen8_ppgtt_alloc(struct i915_address_space * const vm,
 				}
 
 				if (intel_vgpu_active(vm->i915) ||
-				    gen8_pt_count(*start, end) < I915_PDES)
+				    (!clean &&
+				     gen8_pt_count(*start, end) < I915_PDES))
 					fill_px(pt, vm->scratch[lvl].encode);
 			}
 
@@ -1107,7 +1195,7 @@ static int __gen8_ppgtt_alloc(struct i915_address_space * const vm,
 						 start, end, lvl);
 			if (unlikely(ret)) {
 				if (release_pd_entry(pd, idx, pt, scratch))
-					free_px(vm, pt);
+					gen8_free_px(vm, pt, lvl, false);
 				goto out;
 			}
 
@@ -1131,7 +1219,7 @@ static int __gen8_ppgtt_alloc(struct i915_address_space * const vm,
 	spin_unlock(&pd->lock);
 out:
 	if (alloc)
-		free_px(vm, alloc);
+		gen8_free_px(vm, alloc, lvl, false);
 	return ret;
 }
 
@@ -1535,6 +1623,7 @@ static struct i915_ppgtt *gen8_ppgtt_create(struct drm_i915_private *i915)
 err_free_pd:
 	__gen8_ppgtt_cleanup(&ppgtt->vm, ppgtt->pd,
 			     gen8_pd_top_count(&ppgtt->vm), ppgtt->vm.top);
+	gen8_pt_cache_fini(&ppgtt->vm);
 err_free_scratch:
 	free_scratch(&ppgtt->vm);
 err_free:
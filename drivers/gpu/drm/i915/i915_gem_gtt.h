@@ -56,6 +56,11 @@
 #define I915_GTT_PAGE_SIZE_64K	BIT_ULL(16)
 #define I915_GTT_PAGE_SIZE_2M	BIT_ULL(21)
 
+#define I915_GTT_PAGE_SIZE_IDX_4K	0
+#define I915_GTT_PAGE_SIZE_IDX_64K	1
+#define I915_GTT_PAGE_SIZE_IDX_2M	2
+#define I915_GTT_PAGE_SIZE_IDX_COUNT	3
+
 #define I915_GTT_PAGE_SIZE I915_GTT_PAGE_SIZE_4K
 #define I915_GTT_MAX_PAGE_SIZE I915_GTT_PAGE_SIZE_2M
 
@@ -236,6 +241,8 @@ struct i915_page_scratch {
 	u64 encode;
 };
 
+#define I915_PT_CACHE_SIZE 8
+
 struct i915_page_table {
 	struct i915_page_dma base;
 	atomic_t used;
@@ -330,6 +337,19 @@ struct i915_address_space {
 
 	struct pagestash free_pages;
 
+	/*
+	 * Page tables and directories released by a gen8 ppGTT, kept
+	 * mapped for reuse. The tables in @clean are known to contain
+	 * only scratch entries.
+	 */
+	struct {
+		spinlock_t lock;
+		unsigned int nclean, ndirty, npd;
+		struct i915_page_table *clean[I915_PT_CACHE_SIZE];
+		struct i915_page_table *dirty[I915_PT_CACHE_SIZE];
+		struct i915_page_directory *pd[I915_PT_CACHE_SIZE];
+	} pt_cache;
+
 	/* Global GTT */
 	bool is_ggtt:1;
 
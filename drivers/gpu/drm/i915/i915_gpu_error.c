@@ -50,6 +50,13 @@
 #define ALLOW_FAIL (GFP_KERNEL | __GFP_RETRY_MAYFAIL | __GFP_NOWARN)
 #define ATOMIC_MAYFAIL (GFP_ATOMIC | __GFP_NOWARN)
 
+/*
+ * Limit how much memory a single error state may hold on to, so that a
+ * hang with a few huge objects attached does not take the rest of the
+ * system down with it. Objects that no longer fit are left out.
+ */
+#define ERROR_CAPTURE_PAGES (SZ_128M >> PAGE_SHIFT)
+
 static void __sg_set_buf(struct scatterlist *sg,
 			 void *addr, unsigned int len, loff_t it)
 {
@@ -240,6 +247,7 @@ static void pool_free(struct pagevec *pv, void *addr)
 struct compress {
 	struct pagevec pool;
 	struct z_stream_s zstream;
+	unsigned long budget;
 	void *tmp;
 };
 
@@ -258,6 +266,8 @@ static bool compress_init(struct compress *c)
 		return false;
 	}
 
+	c->budget = ERROR_CAPTURE_PAGES;
+
 	c->tmp = NULL;
 	if (i915_has_memcpy_from_wc())
 		c->tmp = pool_alloc(&c->pool, ALLOW_FAIL);
@@ -281,13 +291,14 @@ static void *compress_next_page(struct compress *c,
 {
 	void *page;
 
-	if (dst->page_count >= dst->num_pages)
+	if (dst->page_count >= dst->num_pages || !c->budget)
 		return ERR_PTR(-ENOSPC);
 
 	page = pool_alloc(&c->pool, ALLOW_FAIL);
 	if (!page)
 		return ERR_PTR(-ENOMEM);
 
+	c->budget--;
 	return dst->pages[dst->page_count++] = page;
 }
 
@@ -373,10 +384,12 @@ static void err_compression_marker(struct drm_i915_error_state_buf *m)
 
 struct compress {
 	struct pagevec pool;
+	unsigned long budget;
 };
 
 static bool compress_init(struct compress *c)
 {
+	c->budget = ERROR_CAPTURE_PAGES;
 	return pool_init(&c->pool, ALLOW_FAIL) == 0;
 }
 
@@ -391,10 +404,14 @@ static int compress_page(struct compress *c,
 {
 	void *ptr;
 
+	if (!c->budget)
+		return -ENOSPC;
+
 	ptr = pool_alloc(&c->pool, ALLOW_FAIL);
 	if (!ptr)
 		return -ENOMEM;
 
+	c->budget--;
 	if (!i915_memcpy_from_wc(ptr, src, PAGE_SIZE))
 		memcpy(ptr, src, PAGE_SIZE);
 	dst->pages[dst->page_count++] = ptr;
@@ -1007,9 +1024,14 @@ i915_error_object_create(struct drm_i915_private *i915,
 		io_mapping_unmap(s);
 		if (ret)
 			break;
+
+		/* Large objects take a while, let others (and reset) run */
+		cond_resched();
 	}
 
 	if (ret || compress_flush(compress, dst)) {
+		/* Leave the space for the objects that still fit */
+		compress->budget += dst->page_count;
 		while (dst->page_count--)
 			pool_free(&compress->pool, dst->pages[dst->page_count]);
 		kfree(dst);
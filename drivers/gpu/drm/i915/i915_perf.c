@@ -274,6 +274,10 @@
 #define POLL_FREQUENCY 200
 #define POLL_PERIOD (NSEC_PER_SEC / POLL_FREQUENCY)
 
+/* ...and the bounds within which that period is adapted to the report rate */
+#define POLL_PERIOD_MIN (NSEC_PER_SEC / 1000)
+#define POLL_PERIOD_MAX (NSEC_PER_SEC / 10)
+
 /* for sysctl proc_dointvec_minmax of dev.i915.perf_stream_paranoid */
 static u32 i915_perf_stream_paranoid = true;
 
@@ -329,6 +333,9 @@ static const struct i915_oa_format hsw_oa_formats[I915_OA_FORMAT_MAX] = {
 	[I915_OA_FORMAT_C4_B8]	    = { 7, 64 },
 };
 
+/* The largest of the report formats above and below */
+#define OA_REPORT_MAX_SIZE 256
+
 static const struct i915_oa_format gen8_plus_oa_formats[I915_OA_FORMAT_MAX] = {
 	[I915_OA_FORMAT_A12]		    = { 0, 64 },
 	[I915_OA_FORMAT_A12_B8_C8]	    = { 2, 128 },
@@ -347,6 +354,7 @@ static const struct i915_oa_format gen8_plus_oa_formats[I915_OA_FORMAT_MAX] = {
  * @oa_format: An OA unit HW report format
  * @oa_periodic: Whether to enable periodic OA unit sampling
  * @oa_period_exponent: The OA unit sampling period is derived from this
+ * @oa_period: The OA unit sampling period in nanoseconds
  *
  * As read_properties_unlocked() enumerates and validates the properties given
  * to open a stream of metrics the configuration is built up in the structure
@@ -363,6 +371,7 @@ struct perf_open_properties {
 	int oa_format;
 	bool oa_periodic;
 	int oa_period_exponent;
+	u64 oa_period;
 };
 
 static enum hrtimer_restart oa_poll_check_timer_cb(struct hrtimer *hrtimer);
@@ -486,6 +495,8 @@ static bool oa_buffer_check_unlocked(struct i915_perf_stream *stream)
 	 */
 	hw_tail &= ~(report_size - 1);
 
+	stream->oa_buffer.hw_tail = hw_tail;
+
 	now = ktime_get_mono_fast_ns();
 
 	/* Update the aged tail
@@ -605,27 +616,33 @@ static int append_oa_sample(struct i915_perf_stream *stream,
 			    const u8 *report)
 {
 	int report_size = stream->oa_buffer.format_size;
-	struct drm_i915_perf_record_header header;
+	struct {
+		struct drm_i915_perf_record_header header;
+		u8 report[OA_REPORT_MAX_SIZE];
+	} sample;
 	u32 sample_flags = stream->sample_flags;
 
-	header.type = DRM_I915_PERF_RECORD_SAMPLE;
-	header.pad = 0;
-	header.size = stream->sample_size;
+	sample.header.type = DRM_I915_PERF_RECORD_SAMPLE;
+	sample.header.pad = 0;
+	sample.header.size = stream->sample_size;
 
-	if ((count - *offset) < header.size)
+	if ((count - *offset) < sample.header.size)
 		return -ENOSPC;
 
-	buf += *offset;
-	if (copy_to_user(buf, &header, sizeof(header)))
-		return -EFAULT;
-	buf += sizeof(header);
-
+	/*
+	 * Assemble the whole record first so that each sample costs a
+	 * single copy_to_user(), which dominates at high sampling rates.
+	 */
 	if (sample_flags & SAMPLE_OA_REPORT) {
-		if (copy_to_user(buf, report, report_size))
-			return -EFAULT;
+		GEM_BUG_ON(report_size > sizeof(sample.report));
+		memcpy(sample.report, report, report_size);
 	}
 
-	(*offset) += header.size;
+	GEM_BUG_ON(sample.header.size > sizeof(sample));
+	if (copy_to_user(buf + *offset, &sample, sample.header.size))
+		return -EFAULT;
+
+	(*offset) += sample.header.size;
 
 	return 0;
 }
@@ -893,6 +910,8 @@ static int gen8_oa_read(struct i915_perf_stream *stream,
 		if (ret)
 			return ret;
 
+		atomic64_inc(&dev_priv->perf.oa_buffer_overflows);
+
 		DRM_DEBUG("OA buffer overflow (exponent = %d): force restart\n",
 			  stream->period_exponent);
 
@@ -911,6 +930,9 @@ static int gen8_oa_read(struct i915_perf_stream *stream,
 				       DRM_I915_PERF_RECORD_OA_REPORT_LOST);
 		if (ret)
 			return ret;
+
+		atomic64_inc(&dev_priv->perf.oa_reports_lost);
+
 		I915_WRITE(GEN8_OASTATUS,
 			   oastatus & ~GEN8_OASTATUS_REPORT_LOST);
 	}
@@ -1117,6 +1139,8 @@ static int gen7_oa_read(struct i915_perf_stream *stream,
 		if (ret)
 			return ret;
 
+		atomic64_inc(&dev_priv->perf.oa_buffer_overflows);
+
 		DRM_DEBUG("OA buffer overflow (exponent = %d): force restart\n",
 			  stream->period_exponent);
 
@@ -1131,6 +1155,9 @@ static int gen7_oa_read(struct i915_perf_stream *stream,
 				       DRM_I915_PERF_RECORD_OA_REPORT_LOST);
 		if (ret)
 			return ret;
+
+		atomic64_inc(&dev_priv->perf.oa_reports_lost);
+
 		dev_priv->perf.gen7_latched_oastatus1 |=
 			GEN7_OASTATUS1_REPORT_LOST;
 	}
@@ -1404,6 +1431,8 @@ static void gen7_init_oa_buffer(struct i915_perf_stream *stream)
 	I915_WRITE(GEN7_OASTATUS2,
 		   gtt_offset | GEN7_OASTATUS2_MEM_SELECT_GGTT); /* head */
 	stream->oa_buffer.head = gtt_offset;
+	stream->oa_buffer.hw_tail = gtt_offset;
+	stream->poll_oa_tail = gtt_offset;
 
 	I915_WRITE(GEN7_OABUFFER, gtt_offset);
 
@@ -1451,6 +1480,8 @@ static void gen8_init_oa_buffer(struct i915_perf_stream *stream)
 	I915_WRITE(GEN8_OASTATUS, 0);
 	I915_WRITE(GEN8_OAHEADPTR, gtt_offset);
 	stream->oa_buffer.head = gtt_offset;
+	stream->oa_buffer.hw_tail = gtt_offset;
+	stream->poll_oa_tail = gtt_offset;
 
 	I915_WRITE(GEN8_OABUFFER_UDW, 0);
 
@@ -2089,10 +2120,12 @@ static void i915_oa_stream_enable(struct i915_perf_stream *stream)
 
 	dev_priv->perf.ops.oa_enable(stream);
 
-	if (stream->periodic)
+	if (stream->periodic) {
+		stream->poll_oa_period = stream->poll_oa_period_min;
 		hrtimer_start(&stream->poll_check_timer,
-			      ns_to_ktime(POLL_PERIOD),
+			      ns_to_ktime(stream->poll_oa_period),
 			      HRTIMER_MODE_REL_PINNED);
+	}
 }
 
 static void gen7_oa_disable(struct i915_perf_stream *stream)
@@ -2144,6 +2177,28 @@ static const struct i915_perf_stream_ops i915_oa_stream_ops = {
 	.read = i915_oa_read,
 };
 
+/*
+ * There is no point checking the OA buffer more often than a periodic
+ * report can arrive, but we must look several times before the periodic
+ * reports alone could wrap the buffer. While idle, the poll period may
+ * back off up to POLL_PERIOD_MAX, bounded by the same wrap limit.
+ */
+static void oa_poll_period_init(struct i915_perf_stream *stream,
+				u64 oa_period)
+{
+	u64 wrap = div_u64(OA_BUFFER_SIZE, stream->oa_buffer.format_size) *
+		   oa_period;
+	u64 period;
+
+	period = clamp_t(u64, oa_period, POLL_PERIOD, POLL_PERIOD_MAX);
+	period = max_t(u64, min(period, wrap / 8), POLL_PERIOD_MIN);
+
+	stream->poll_oa_period_min = period;
+	stream->poll_oa_period_max =
+		max_t(u64, min_t(u64, wrap / 4, POLL_PERIOD_MAX), period);
+	stream->poll_oa_period = period;
+}
+
 /**
  * i915_oa_stream_init - validate combined props for OA stream and init
  * @stream: An i915 perf stream
@@ -2218,8 +2273,10 @@ static int i915_oa_stream_init(struct i915_perf_stream *stream,
 		dev_priv->perf.oa_formats[props->oa_format].format;
 
 	stream->periodic = props->oa_periodic;
-	if (stream->periodic)
+	if (stream->periodic) {
 		stream->period_exponent = props->oa_period_exponent;
+		oa_poll_period_init(stream, props->oa_period);
+	}
 
 	if (stream->ctx) {
 		ret = oa_get_render_ctx_id(stream);
@@ -2435,13 +2492,36 @@ static enum hrtimer_restart oa_poll_check_timer_cb(struct hrtimer *hrtimer)
 {
 	struct i915_perf_stream *stream =
 		container_of(hrtimer, typeof(*stream), poll_check_timer);
+	bool pending = READ_ONCE(stream->pollin);
+	u64 period = stream->poll_oa_period;
+	u32 tail, moved;
 
 	if (oa_buffer_check_unlocked(stream)) {
 		stream->pollin = true;
 		wake_up(&stream->poll_wq);
 	}
 
-	hrtimer_forward_now(hrtimer, ns_to_ktime(POLL_PERIOD));
+	tail = READ_ONCE(stream->oa_buffer.hw_tail);
+	moved = OA_TAKEN(tail, stream->poll_oa_tail);
+	stream->poll_oa_tail = tail;
+
+	if (!moved) {
+		/* No new reports (e.g. the filtered context is idle), back off */
+		period = min(period * 2, stream->poll_oa_period_max);
+	} else if (pending) {
+		/*
+		 * The reader has yet to consume our last wakeup, so waking
+		 * it more often won't help; leave the period alone.
+		 */
+	} else if (moved >= OA_BUFFER_SIZE / 4) {
+		/* Reports are arriving fast, check before the buffer wraps */
+		period = max_t(u64, period / 2, POLL_PERIOD_MIN);
+	} else {
+		period = stream->poll_oa_period_min;
+	}
+	stream->poll_oa_period = period;
+
+	hrtimer_forward_now(hrtimer, ns_to_ktime(period));
 
 	return HRTIMER_RESTART;
 }
@@ -2948,6 +3028,7 @@ static int read_properties_unlocked(struct drm_i915_private *dev_priv,
 
 			props->oa_periodic = true;
 			props->oa_period_exponent = value;
+			props->oa_period = oa_period;
 			break;
 		case DRM_I915_PERF_PROP_MAX:
 			MISSING_CASE(id);
@@ -42,6 +42,14 @@ enum {
 
 #define __NO_PREEMPTION (I915_PRIORITY_WAIT)
 
+/*
+ * Besides I915_PRIORITY_NORMAL, only a handful of priorities are seen in
+ * practice (the display boost, the extremes and those either side of
+ * normal). Each engine carries a preallocated priolist for those, see
+ * i915_priolist_slot().
+ */
+#define I915_PRIOLIST_FIXED 4
+
 struct i915_priolist {
 	struct list_head requests[I915_PRIORITY_COUNT];
 	struct rb_node node;
@@ -100,6 +100,57 @@ static signed long i915_fence_wait(struct dma_fence *fence,
 				 timeout);
 }
 
+static bool request_cache_put(struct i915_request *rq)
+{
+	struct intel_engine_cs *engine = rq->engine;
+	unsigned long flags;
+	bool cached = false;
+
+	/* Only requests bound to a physical engine, virtual ones are freed */
+	if (!(rq->flags & I915_REQUEST_CACHEABLE))
+		return false;
+
+	if (READ_ONCE(engine->request_cache.count) ==
+	    ARRAY_SIZE(engine->request_cache.free))
+		return false;
+
+	spin_lock_irqsave(&engine->request_cache.lock, flags);
+	if (engine->request_cache.count <
+	    ARRAY_SIZE(engine->request_cache.free)) {
+		engine->request_cache.free[engine->request_cache.count++] = rq;
+		cached = true;
+	}
+	spin_unlock_irqrestore(&engine->request_cache.lock, flags);
+
+	return cached;
+}
+
+static struct i915_request *request_cache_get(struct intel_engine_cs *engine)
+{
+	struct i915_request *rq = NULL;
+	unsigned long flags;
+
+	if (!READ_ONCE(engine->request_cache.count))
+		return NULL;
+
+	spin_lock_irqsave(&engine->request_cache.lock, flags);
+	if (engine->request_cache.count)
+		rq = engine->request_cache.free[--engine->request_cache.count];
+	spin_unlock_irqrestore(&engine->request_cache.lock, flags);
+
+	return rq;
+}
+
+void i915_request_cache_fini(struct intel_engine_cs *engine)
+{
+	unsigned int i;
+
+	for (i = 0; i < engine->request_cache.count; i++)
+		kmem_cache_free(global.slab_requests,
+				engine->request_cache.free[i]);
+	engine->request_cache.count = 0;
+}
+
 static void i915_fence_release(struct dma_fence *fence)
 {
 	struct i915_request *rq = to_request(fence);
@@ -114,6 +165,13 @@ static void i915_fence_release(struct dma_fence *fence)
 	i915_sw_fence_fini(&rq->submit);
 	i915_sw_fence_fini(&rq->semaphore);
 
+	/*
+	 * As with the slab, the request may still be looked at under RCU
+	 * and so is only ever reused as another request.
+	 */
+	if (request_cache_put(rq))
+		return;
+
 	kmem_cache_free(global.slab_requests, rq);
 }
 
@@ -676,8 +734,10 @@ __i915_request_create(struct intel_context *ce, gfp_t gfp)
 	 *
 	 * Do not use kmem_cache_zalloc() here!
 	 */
-	rq = kmem_cache_alloc(global.slab_requests,
-			      gfp | __GFP_RETRY_MAYFAIL | __GFP_NOWARN);
+	rq = request_cache_get(ce->engine);
+	if (!rq)
+		rq = kmem_cache_alloc(global.slab_requests,
+				      gfp | __GFP_RETRY_MAYFAIL | __GFP_NOWARN);
 	if (unlikely(!rq)) {
 		rq = request_alloc_slow(tl, gfp);
 		if (!rq) {
@@ -719,6 +779,8 @@ __i915_request_create(struct intel_context *ce, gfp_t gfp)
 	rq->batch = NULL;
 	rq->capture_list = NULL;
 	rq->flags = 0;
+	if (!intel_engine_is_virtual(ce->engine))
+		rq->flags |= I915_REQUEST_CACHEABLE;
 	rq->execution_mask = ALL_ENGINES;
 
 	INIT_LIST_HEAD(&rq->active_list);
@@ -906,7 +968,8 @@ i915_request_await_request(struct i915_request *to, struct i915_request *from)
 	if (i915_request_completed(from))
 		return 0;
 
-	if (to->engine->schedule) {
+	/* Priority inheritance is tracked per device */
+	if (to->engine->schedule && to->i915 == from->i915) {
 		ret = i915_sched_node_add_dependency(&to->sched, &from->sched);
 		if (ret < 0)
 			return ret;
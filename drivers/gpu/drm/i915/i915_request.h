@@ -221,6 +221,7 @@ struct i915_request {
 	unsigned long flags;
 #define I915_REQUEST_WAITBOOST BIT(0)
 #define I915_REQUEST_NOPREEMPT BIT(1)
+#define I915_REQUEST_CACHEABLE BIT(2)
 
 	/** timeline->request entry for this request */
 	struct list_head link;
@@ -254,6 +255,7 @@ void __i915_request_queue(struct i915_request *rq,
 			  const struct i915_sched_attr *attr);
 
 void i915_request_retire_upto(struct i915_request *rq);
+void i915_request_cache_fini(struct intel_engine_cs *engine);
 
 static inline struct i915_request *
 to_request(struct dma_fence *fence)
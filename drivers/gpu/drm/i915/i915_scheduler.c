@@ -17,14 +17,23 @@ static struct i915_global_scheduler {
 	struct kmem_cache *slab_priorities;
 } global;
 
-static DEFINE_SPINLOCK(schedule_lock);
-
 static const struct i915_request *
 node_to_request(const struct i915_sched_node *node)
 {
 	return container_of(node, const struct i915_request, sched);
 }
 
+/*
+ * The dependency graph never crosses devices (see
+ * i915_request_await_request()), so each device serialises the walk
+ * over its own graph and priority changes on one GPU do not contend
+ * with those of another.
+ */
+static inline spinlock_t *node_schedule_lock(const struct i915_sched_node *node)
+{
+	return &node_to_request(node)->i915->gt.schedule_lock;
+}
+
 static inline bool node_started(const struct i915_sched_node *node)
 {
 	return i915_request_started(node_to_request(node));
@@ -72,7 +81,7 @@ struct list_head *
 i915_sched_lookup_priolist(struct intel_engine_cs *engine, int prio)
 {
 	struct intel_engine_execlists * const execlists = &engine->execlists;
-	struct i915_priolist *p;
+	struct i915_priolist *p, *fixed;
 	struct rb_node **parent, *rb;
 	bool first = true;
 	int idx, i;
@@ -87,6 +96,20 @@ i915_sched_lookup_priolist(struct intel_engine_cs *engine, int prio)
 		prio = I915_PRIORITY_NORMAL;
 
 find_priolist:
+	/*
+	 * The common priorities have their own preallocated lists, and if
+	 * one is already in the queue we can use it without searching.
+	 */
+	fixed = NULL;
+	if (prio == I915_PRIORITY_NORMAL)
+		fixed = &execlists->default_priolist;
+	else if ((i = i915_priolist_slot(prio)) >= 0)
+		fixed = &execlists->fixed_priolist[i];
+	if (fixed && !RB_EMPTY_NODE(&fixed->node)) {
+		p = fixed;
+		goto out;
+	}
+
 	/* most positive priority is scheduled first, equal priorities fifo */
 	rb = NULL;
 	parent = &execlists->queue.rb_root.rb_node;
@@ -103,8 +126,8 @@ find_priolist:
 		}
 	}
 
-	if (prio == I915_PRIORITY_NORMAL) {
-		p = &execlists->default_priolist;
+	if (fixed) {
+		p = fixed;
 	} else {
 		p = kmem_cache_alloc(global.slab_priorities, GFP_ATOMIC);
 		/* Convert an allocation failure to a priority bump */
@@ -238,7 +261,7 @@ static void __i915_schedule(struct i915_sched_node *node,
 	LIST_HEAD(dfs);
 
 	/* Needed in order to use the temporary link inside i915_dependency */
-	lockdep_assert_held(&schedule_lock);
+	lockdep_assert_held(node_schedule_lock(node));
 	GEM_BUG_ON(prio == I915_PRIORITY_INVALID);
 
 	if (prio <= READ_ONCE(node->attr.priority))
@@ -359,9 +382,22 @@ static void __i915_schedule(struct i915_sched_node *node,
 
 void i915_schedule(struct i915_request *rq, const struct i915_sched_attr *attr)
 {
-	spin_lock_irq(&schedule_lock);
+	spinlock_t *lock = node_schedule_lock(&rq->sched);
+
+	/*
+	 * Priorities only ever increase until the request is signaled, so
+	 * there is no need to serialise with everybody else just to find
+	 * out that there is nothing to do.
+	 */
+	if (attr->priority <= READ_ONCE(rq->sched.attr.priority))
+		return;
+
+	if (i915_request_completed(rq))
+		return;
+
+	spin_lock_irq(lock);
 	__i915_schedule(&rq->sched, attr);
-	spin_unlock_irq(&schedule_lock);
+	spin_unlock_irq(lock);
 }
 
 static void __bump_priority(struct i915_sched_node *node, unsigned int bump)
@@ -380,9 +416,12 @@ void i915_schedule_bump_priority(struct i915_request *rq, unsigned int bump)
 	if (READ_ONCE(rq->sched.attr.priority) & bump)
 		return;
 
-	spin_lock_irqsave(&schedule_lock, flags);
+	if (i915_request_completed(rq))
+		return;
+
+	spin_lock_irqsave(node_schedule_lock(&rq->sched), flags);
 	__bump_priority(&rq->sched, bump);
-	spin_unlock_irqrestore(&schedule_lock, flags);
+	spin_unlock_irqrestore(node_schedule_lock(&rq->sched), flags);
 }
 
 void i915_sched_node_init(struct i915_sched_node *node)
@@ -412,9 +451,17 @@ bool __i915_sched_node_add_dependency(struct i915_sched_node *node,
 				      struct i915_dependency *dep,
 				      unsigned long flags)
 {
+	spinlock_t *lock = node_schedule_lock(node);
 	bool ret = false;
 
-	spin_lock_irq(&schedule_lock);
+	GEM_BUG_ON(node_to_request(signal)->i915 !=
+		   node_to_request(node)->i915);
+
+	/* Once signaled, it stays signaled */
+	if (node_signaled(signal))
+		return false;
+
+	spin_lock_irq(lock);
 
 	if (!node_signaled(signal)) {
 		INIT_LIST_HEAD(&dep->dfs_link);
@@ -442,7 +489,7 @@ bool __i915_sched_node_add_dependency(struct i915_sched_node *node,
 		ret = true;
 	}
 
-	spin_unlock_irq(&schedule_lock);
+	spin_unlock_irq(lock);
 
 	return ret;
 }
@@ -466,9 +513,10 @@ int i915_sched_node_add_dependency(struct i915_sched_node *node,
 
 void i915_sched_node_fini(struct i915_sched_node *node)
 {
+	spinlock_t *lock = node_schedule_lock(node);
 	struct i915_dependency *dep, *tmp;
 
-	spin_lock_irq(&schedule_lock);
+	spin_lock_irq(lock);
 
 	/*
 	 * Everyone we depended upon (the fences we wait to be signaled)
@@ -495,7 +543,7 @@ void i915_sched_node_fini(struct i915_sched_node *node)
 			i915_dependency_free(dep);
 	}
 
-	spin_unlock_irq(&schedule_lock);
+	spin_unlock_irq(lock);
 }
 
 static void i915_global_scheduler_shrink(void)
@@ -45,10 +45,30 @@ void i915_schedule_bump_priority(struct i915_request *rq, unsigned int bump);
 struct list_head *
 i915_sched_lookup_priolist(struct intel_engine_cs *engine, int prio);
 
+static inline int i915_priolist_slot(int prio)
+{
+	switch (prio) {
+	case I915_PRIORITY_MAX:
+		return 0;
+	case I915_PRIORITY_NORMAL + 1:
+		return 1;
+	case I915_PRIORITY_NORMAL - 1:
+		return 2;
+	case I915_PRIORITY_MIN:
+		return 3;
+	default:
+		return -1;
+	}
+}
+
 void __i915_priolist_free(struct i915_priolist *p);
 static inline void i915_priolist_free(struct i915_priolist *p)
 {
-	if (p->priority != I915_PRIORITY_NORMAL)
+	/* The preallocated lists are simply marked as no longer in the queue */
+	if (p->priority == I915_PRIORITY_NORMAL ||
+	    i915_priolist_slot(p->priority) >= 0)
+		RB_CLEAR_NODE(&p->node);
+	else
 		__i915_priolist_free(p);
 }
 
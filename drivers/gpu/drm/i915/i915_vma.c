@@ -291,6 +291,18 @@ i915_vma_instance(struct drm_i915_gem_object *obj,
 	return vma;
 }
 
+/* ppGTT bindings are accounted by the largest page size used to map them */
+static atomic64_t *vma_page_size_counter(const struct i915_vma *vma)
+{
+	atomic64_t *bytes = vma->vm->i915->mm.gtt_page_size_bytes;
+
+	if (vma->page_sizes.gtt & I915_GTT_PAGE_SIZE_2M)
+		return &bytes[I915_GTT_PAGE_SIZE_IDX_2M];
+	if (vma->page_sizes.gtt & I915_GTT_PAGE_SIZE_64K)
+		return &bytes[I915_GTT_PAGE_SIZE_IDX_64K];
+	return &bytes[I915_GTT_PAGE_SIZE_IDX_4K];
+}
+
 /**
  * i915_vma_bind - Sets up PTEs for an VMA in it's corresponding address space.
  * @vma: VMA to map
@@ -340,6 +352,9 @@ int i915_vma_bind(struct i915_vma *vma, enum i915_cache_level cache_level,
 	if (ret)
 		return ret;
 
+	if (!i915_is_ggtt(vma->vm) && bind_flags & ~vma_flags & I915_VMA_LOCAL_BIND)
+		atomic64_add(vma->size, vma_page_size_counter(vma));
+
 	vma->flags |= bind_flags;
 	return 0;
 }
@@ -665,6 +680,7 @@ i915_vma_insert(struct i915_vma *vma, u64 size, u64 alignment, u64 flags)
 	if (vma->obj) {
 		atomic_inc(&vma->obj->bind_count);
 		assert_bind_count(vma->obj);
+		i915_gem_object_check_parked(vma->obj);
 	}
 
 	return 0;
@@ -1025,6 +1041,8 @@ int i915_vma_unbind(struct i915_vma *vma)
 		trace_i915_vma_unbind(vma);
 		vma->ops->unbind_vma(vma);
 	}
+	if (!i915_is_ggtt(vma->vm) && vma->flags & I915_VMA_LOCAL_BIND)
+		atomic64_sub(vma->size, vma_page_size_counter(vma));
 	vma->flags &= ~(I915_VMA_GLOBAL_BIND | I915_VMA_LOCAL_BIND);
 
 	i915_vma_remove(vma);
@@ -57,6 +57,16 @@ static struct attribute ttm_bo_count = {
 	.mode = S_IRUGO
 };
 
+static struct attribute ttm_bo_vm_faults = {
+	.name = "vm_faults",
+	.mode = S_IRUGO
+};
+
+static struct attribute ttm_bo_vm_faults_saved = {
+	.name = "vm_faults_saved",
+	.mode = S_IRUGO
+};
+
 /* default destructor */
 static void ttm_bo_default_destroy(struct ttm_buffer_object *bo)
 {
@@ -124,12 +134,21 @@ static ssize_t ttm_bo_global_show(struct kobject *kobj,
 	struct ttm_bo_global *glob =
 		container_of(kobj, struct ttm_bo_global, kobj);
 
+	if (attr == &ttm_bo_vm_faults)
+		return snprintf(buffer, PAGE_SIZE, "%ld\n",
+				atomic_long_read(&glob->vm_faults));
+	if (attr == &ttm_bo_vm_faults_saved)
+		return snprintf(buffer, PAGE_SIZE, "%ld\n",
+				atomic_long_read(&glob->vm_faults_saved));
+
 	return snprintf(buffer, PAGE_SIZE, "%d\n",
 				atomic_read(&glob->bo_count));
 }
 
 static struct attribute *ttm_bo_global_attrs[] = {
 	&ttm_bo_count,
+	&ttm_bo_vm_faults,
+	&ttm_bo_vm_faults_saved,
 	NULL
 };
 
@@ -272,6 +291,50 @@ void ttm_bo_move_to_lru_tail(struct ttm_buffer_object *bo,
 }
 EXPORT_SYMBOL(ttm_bo_move_to_lru_tail);
 
+bool ttm_bo_bulk_move_at_tail(struct ttm_lru_bulk_move *bulk)
+{
+	unsigned i;
+
+	for (i = 0; i < TTM_MAX_BO_PRIORITY; ++i) {
+		struct ttm_lru_bulk_move_pos *pos = &bulk->tt[i];
+		struct ttm_mem_type_manager *man;
+
+		if (!pos->first)
+			continue;
+
+		man = &pos->last->bdev->man[TTM_PL_TT];
+		if (READ_ONCE(pos->last->lru.next) != &man->lru[i])
+			return false;
+	}
+
+	for (i = 0; i < TTM_MAX_BO_PRIORITY; ++i) {
+		struct ttm_lru_bulk_move_pos *pos = &bulk->vram[i];
+		struct ttm_mem_type_manager *man;
+
+		if (!pos->first)
+			continue;
+
+		man = &pos->last->bdev->man[TTM_PL_VRAM];
+		if (READ_ONCE(pos->last->lru.next) != &man->lru[i])
+			return false;
+	}
+
+	for (i = 0; i < TTM_MAX_BO_PRIORITY; ++i) {
+		struct ttm_lru_bulk_move_pos *pos = &bulk->swap[i];
+		struct list_head *lru;
+
+		if (!pos->first)
+			continue;
+
+		lru = &pos->last->bdev->glob->swap_lru[i];
+		if (READ_ONCE(pos->last->swap.next) != lru)
+			return false;
+	}
+
+	return true;
+}
+EXPORT_SYMBOL(ttm_bo_bulk_move_at_tail);
+
 void ttm_bo_bulk_move_lru_tail(struct ttm_lru_bulk_move *bulk)
 {
 	unsigned i;
@@ -287,6 +350,9 @@ void ttm_bo_bulk_move_lru_tail(struct ttm_lru_bulk_move *bulk)
 		dma_resv_assert_held(pos->last->base.resv);
 
 		man = &pos->first->bdev->man[TTM_PL_TT];
+		if (list_is_last(&pos->last->lru, &man->lru[i]))
+			continue;
+
 		list_bulk_move_tail(&man->lru[i], &pos->first->lru,
 				    &pos->last->lru);
 	}
@@ -302,6 +368,9 @@ void ttm_bo_bulk_move_lru_tail(struct ttm_lru_bulk_move *bulk)
 		dma_resv_assert_held(pos->last->base.resv);
 
 		man = &pos->first->bdev->man[TTM_PL_VRAM];
+		if (list_is_last(&pos->last->lru, &man->lru[i]))
+			continue;
+
 		list_bulk_move_tail(&man->lru[i], &pos->first->lru,
 				    &pos->last->lru);
 	}
@@ -317,6 +386,9 @@ void ttm_bo_bulk_move_lru_tail(struct ttm_lru_bulk_move *bulk)
 		dma_resv_assert_held(pos->last->base.resv);
 
 		lru = &pos->first->bdev->glob->swap_lru[i];
+		if (list_is_last(&pos->last->swap, lru))
+			continue;
+
 		list_bulk_move_tail(lru, &pos->first->swap, &pos->last->swap);
 	}
 }
@@ -617,13 +689,30 @@ static int ttm_bo_cleanup_refs(struct ttm_buffer_object *bo,
 	return 0;
 }
 
+/*
+ * Number of buffers the delayed delete worker handles before dropping
+ * a reservation it shares between them, or the lru lock while skipping
+ * busy buffers.
+ */
+#define TTM_BO_DELAYED_DELETE_BATCH 64
+
 /**
  * Traverse the delayed list, and call ttm_bo_cleanup_refs on all
  * encountered buffers.
+ *
+ * Unless removing everything, buffers with unsignaled fences are skipped
+ * without taking their reservation, and a reservation shared by
+ * consecutive buffers (e.g. all page tables of one VM) is kept locked
+ * across a batch of them rather than re-taken for each buffer. The first
+ * buffer of the batch is kept referenced until the reservation is unlocked,
+ * as dropping it may release whatever owns the shared reservation.
  */
 static bool ttm_bo_delayed_delete(struct ttm_bo_device *bdev, bool remove_all)
 {
 	struct ttm_bo_global *glob = bdev->glob;
+	struct ttm_buffer_object *locked_bo = NULL;
+	struct dma_resv *locked = NULL;
+	unsigned int batch = 0, skipped = 0;
 	struct list_head removed;
 	bool empty;
 
@@ -635,20 +724,78 @@ static bool ttm_bo_delayed_delete(struct ttm_bo_device *bdev, bool remove_all)
 
 		bo = list_first_entry(&bdev->ddestroy, struct ttm_buffer_object,
 				      ddestroy);
-		kref_get(&bo->list_kref);
 		list_move_tail(&bo->ddestroy, &removed);
 
-		if (remove_all || bo->base.resv != &bo->base._resv) {
+		if (remove_all) {
+			kref_get(&bo->list_kref);
 			spin_unlock(&glob->lru_lock);
 			dma_resv_lock(bo->base.resv, NULL);
 
 			spin_lock(&glob->lru_lock);
-			ttm_bo_cleanup_refs(bo, false, !remove_all, true);
+			ttm_bo_cleanup_refs(bo, false, false, true);
 
-		} else if (dma_resv_trylock(bo->base.resv)) {
-			ttm_bo_cleanup_refs(bo, false, !remove_all, true);
-		} else {
+			kref_put(&bo->list_kref, ttm_bo_release_list);
+			spin_lock(&glob->lru_lock);
+			continue;
+		}
+
+		/* Still busy, no point in taking the reservation */
+		if (!dma_resv_test_signaled_rcu(&bo->base._resv, true)) {
+			if (++skipped % TTM_BO_DELAYED_DELETE_BATCH == 0) {
+				spin_unlock(&glob->lru_lock);
+				cond_resched();
+				spin_lock(&glob->lru_lock);
+			}
+			continue;
+		}
+
+		kref_get(&bo->list_kref);
+		if (locked && (locked != bo->base.resv ||
+			       batch == TTM_BO_DELAYED_DELETE_BATCH)) {
 			spin_unlock(&glob->lru_lock);
+			dma_resv_unlock(locked);
+			kref_put(&locked_bo->list_kref, ttm_bo_release_list);
+			spin_lock(&glob->lru_lock);
+			locked_bo = NULL;
+			locked = NULL;
+		}
+
+		if (!locked) {
+			if (bo->base.resv != &bo->base._resv) {
+				spin_unlock(&glob->lru_lock);
+				dma_resv_lock(bo->base.resv, NULL);
+				spin_lock(&glob->lru_lock);
+			} else if (!dma_resv_trylock(bo->base.resv)) {
+				spin_unlock(&glob->lru_lock);
+				kref_put(&bo->list_kref, ttm_bo_release_list);
+				spin_lock(&glob->lru_lock);
+				continue;
+			}
+			locked = bo->base.resv;
+			batch = 0;
+		}
+
+		/*
+		 * A reservation embedded in this buffer may be freed with it,
+		 * so only keep shared ones locked for the following buffers.
+		 */
+		if (locked == &bo->base._resv) {
+			ttm_bo_cleanup_refs(bo, false, true, true);
+			locked = NULL;
+
+			/* The batch this owner ended no longer needs pinning */
+			if (locked_bo) {
+				kref_put(&locked_bo->list_kref,
+					 ttm_bo_release_list);
+				locked_bo = NULL;
+			}
+		} else {
+			if (!locked_bo) {
+				kref_get(&bo->list_kref);
+				locked_bo = bo;
+			}
+			ttm_bo_cleanup_refs(bo, false, true, false);
+			batch++;
 		}
 
 		kref_put(&bo->list_kref, ttm_bo_release_list);
@@ -658,6 +805,11 @@ static bool ttm_bo_delayed_delete(struct ttm_bo_device *bdev, bool remove_all)
 	empty = list_empty(&bdev->ddestroy);
 	spin_unlock(&glob->lru_lock);
 
+	if (locked) {
+		dma_resv_unlock(locked);
+		kref_put(&locked_bo->list_kref, ttm_bo_release_list);
+	}
+
 	return empty;
 }
 
@@ -1334,6 +1486,7 @@ int ttm_bo_init_reserved(struct ttm_bo_device *bdev,
 	bo->mem.bus.io_reserved_vm = false;
 	bo->mem.bus.io_reserved_count = 0;
 	bo->moving = NULL;
+	bo->fault_vma = NULL;
 	bo->mem.placement = (TTM_PL_FLAG_SYSTEM | TTM_PL_FLAG_CACHED);
 	bo->acc_size = acc_size;
 	bo->sg = sg;
@@ -1665,6 +1818,8 @@ static int ttm_bo_global_init(void)
 		INIT_LIST_HEAD(&glob->swap_lru[i]);
 	INIT_LIST_HEAD(&glob->device_list);
 	atomic_set(&glob->bo_count, 0);
+	atomic_long_set(&glob->vm_faults, 0);
+	atomic_long_set(&glob->vm_faults_saved, 0);
 
 	ret = kobject_init_and_add(
 		&glob->kobj, &ttm_bo_glob_kobj_type, ttm_get_kobj(), "buffer_objects");
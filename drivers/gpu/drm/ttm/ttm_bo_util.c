@@ -39,6 +39,21 @@
 #include <linux/vmalloc.h>
 #include <linux/module.h>
 #include <linux/dma-resv.h>
+#include <linux/workqueue.h>
+#ifdef CONFIG_AS_MOVNTDQA
+#include <asm/fpu/api.h>
+#ifdef __FreeBSD__
+#include <x86/x86_var.h>
+#define	asm		__asm
+#endif
+#endif
+
+/*
+ * Moves of at least this many pages are split across up to
+ * TTM_MEMCPY_MAX_WORKERS threads.
+ */
+#define TTM_MEMCPY_PARALLEL_PAGES	1024
+#define TTM_MEMCPY_MAX_WORKERS		4
 
 struct ttm_transfer_obj {
 	struct ttm_buffer_object base;
@@ -309,9 +324,108 @@ void ttm_kunmap_atomic_prot(void *addr, pgprot_t prot)
 }
 EXPORT_SYMBOL(ttm_kunmap_atomic_prot);
 
+#ifdef CONFIG_AS_MOVNTDQA
+static bool ttm_has_movntdqa(void)
+{
+#ifdef __linux__
+	/* Same restrictions as i915_memcpy_init_early() */
+	return static_cpu_has(X86_FEATURE_XMM4_1) &&
+		!boot_cpu_has(X86_FEATURE_HYPERVISOR);
+#elif defined(__FreeBSD__)
+	return (cpu_feature2 & CPUID2_SSE41) != 0;
+#endif
+}
+
+/* Streaming loads from a WC source, see i915_memcpy_from_wc(). */
+static void __ttm_memcpy_ntdqa(void *dst, const void *src, unsigned long len)
+{
+	kernel_fpu_begin();
+
+	len >>= 4;
+	while (len >= 4) {
+		asm("movntdqa   (%0), %%xmm0\n"
+		    "movntdqa 16(%0), %%xmm1\n"
+		    "movntdqa 32(%0), %%xmm2\n"
+		    "movntdqa 48(%0), %%xmm3\n"
+		    "movaps %%xmm0,   (%1)\n"
+		    "movaps %%xmm1, 16(%1)\n"
+		    "movaps %%xmm2, 32(%1)\n"
+		    "movaps %%xmm3, 48(%1)\n"
+		    :: "r" (src), "r" (dst) : "memory");
+		src += 64;
+		dst += 64;
+		len -= 4;
+	}
+	while (len--) {
+		asm("movntdqa (%0), %%xmm0\n"
+		    "movaps %%xmm0, (%1)\n"
+		    :: "r" (src), "r" (dst) : "memory");
+		src += 16;
+		dst += 16;
+	}
+
+	kernel_fpu_end();
+}
+
+/* Non-temporal stores to a WC destination. */
+static void __ttm_memcpy_ntdq(void *dst, const void *src, unsigned long len)
+{
+	kernel_fpu_begin();
+
+	len >>= 4;
+	while (len >= 4) {
+		asm("movaps   (%0), %%xmm0\n"
+		    "movaps 16(%0), %%xmm1\n"
+		    "movaps 32(%0), %%xmm2\n"
+		    "movaps 48(%0), %%xmm3\n"
+		    "movntdq %%xmm0,   (%1)\n"
+		    "movntdq %%xmm1, 16(%1)\n"
+		    "movntdq %%xmm2, 32(%1)\n"
+		    "movntdq %%xmm3, 48(%1)\n"
+		    :: "r" (src), "r" (dst) : "memory");
+		src += 64;
+		dst += 64;
+		len -= 4;
+	}
+	while (len--) {
+		asm("movaps (%0), %%xmm0\n"
+		    "movntdq %%xmm0, (%1)\n"
+		    :: "r" (src), "r" (dst) : "memory");
+		src += 16;
+		dst += 16;
+	}
+	asm("sfence" ::: "memory");
+
+	kernel_fpu_end();
+}
+#endif
+
+static void ttm_memcpy_fromio(void *dst, void *src, bool wc)
+{
+#ifdef CONFIG_AS_MOVNTDQA
+	if (wc && ttm_has_movntdqa()) {
+		__ttm_memcpy_ntdqa(dst, src, PAGE_SIZE);
+		return;
+	}
+#endif
+	memcpy_fromio(dst, src, PAGE_SIZE);
+}
+
+static void ttm_memcpy_toio(void *dst, void *src, bool wc)
+{
+#ifdef CONFIG_AS_MOVNTDQA
+	/* movntdq is SSE2, which every CPU with movntdqa has. */
+	if (wc && ttm_has_movntdqa()) {
+		__ttm_memcpy_ntdq(dst, src, PAGE_SIZE);
+		return;
+	}
+#endif
+	memcpy_toio(dst, src, PAGE_SIZE);
+}
+
 static int ttm_copy_io_ttm_page(struct ttm_tt *ttm, void *src,
 				unsigned long page,
-				pgprot_t prot)
+				pgprot_t prot, bool wc)
 {
 	struct page *d = ttm->pages[page];
 	void *dst;
@@ -324,7 +438,7 @@ static int ttm_copy_io_ttm_page(struct ttm_tt *ttm, void *src,
 	if (!dst)
 		return -ENOMEM;
 
-	memcpy_fromio(dst, src, PAGE_SIZE);
+	ttm_memcpy_fromio(dst, src, wc);
 
 	ttm_kunmap_atomic_prot(dst, prot);
 
@@ -333,7 +447,7 @@ static int ttm_copy_io_ttm_page(struct ttm_tt *ttm, void *src,
 
 static int ttm_copy_ttm_io_page(struct ttm_tt *ttm, void *dst,
 				unsigned long page,
-				pgprot_t prot)
+				pgprot_t prot, bool wc)
 {
 	struct page *s = ttm->pages[page];
 	void *src;
@@ -346,13 +460,121 @@ static int ttm_copy_ttm_io_page(struct ttm_tt *ttm, void *dst,
 	if (!src)
 		return -ENOMEM;
 
-	memcpy_toio(dst, src, PAGE_SIZE);
+	ttm_memcpy_toio(dst, src, wc);
 
 	ttm_kunmap_atomic_prot(src, prot);
 
 	return 0;
 }
 
+/**
+ * struct ttm_memcpy_range - A range of pages copied by ttm_bo_move_memcpy.
+ *
+ * @work: Work item, when the range is copied by a worker thread.
+ * @ttm: The ttm backing the system memory side, if any.
+ * @old_iomap: Mapping of the source, or NULL if it is @ttm.
+ * @new_iomap: Mapping of the destination, or NULL if it is @ttm.
+ * @old_mem: The source memory region.
+ * @new_mem: The destination memory region.
+ * @start: First page index to copy.
+ * @end: Page index past the last one to copy.
+ * @dir: 1 to copy forward, -1 to copy backward.
+ * @add: Offset added to the page index when copying backward.
+ * @ret: Result of the copy.
+ */
+struct ttm_memcpy_range {
+	struct work_struct work;
+	struct ttm_tt *ttm;
+	void *old_iomap;
+	void *new_iomap;
+	struct ttm_mem_reg *old_mem;
+	struct ttm_mem_reg *new_mem;
+	unsigned long start;
+	unsigned long end;
+	int dir;
+	unsigned long add;
+	int ret;
+};
+
+static int ttm_copy_range(struct ttm_memcpy_range *r)
+{
+	bool old_wc = r->old_mem->placement & TTM_PL_FLAG_WC;
+	bool new_wc = r->new_mem->placement & TTM_PL_FLAG_WC;
+	unsigned long i;
+	unsigned long page;
+	int ret = 0;
+
+	for (i = r->start; i < r->end; ++i) {
+		page = i * r->dir + r->add;
+		if (r->old_iomap == NULL) {
+			pgprot_t prot = ttm_io_prot(r->old_mem->placement,
+						    PAGE_KERNEL);
+			ret = ttm_copy_ttm_io_page(r->ttm, r->new_iomap, page,
+						   prot, new_wc);
+		} else if (r->new_iomap == NULL) {
+			pgprot_t prot = ttm_io_prot(r->new_mem->placement,
+						    PAGE_KERNEL);
+			ret = ttm_copy_io_ttm_page(r->ttm, r->old_iomap, page,
+						   prot, old_wc);
+		} else {
+			ret = ttm_copy_io_page(r->new_iomap, r->old_iomap,
+					       page);
+		}
+		if (ret)
+			break;
+	}
+
+	return ret;
+}
+
+static void ttm_copy_range_work(struct work_struct *work)
+{
+	struct ttm_memcpy_range *r =
+		container_of(work, struct ttm_memcpy_range, work);
+
+	r->ret = ttm_copy_range(r);
+}
+
+/*
+ * Split a large forward copy into ranges, copy the first one on this
+ * thread and the others on the unbound workqueue.
+ */
+static int ttm_copy_parallel(struct ttm_memcpy_range *tmpl)
+{
+	unsigned long num_pages = tmpl->end - tmpl->start;
+	unsigned int n = min_t(unsigned int, num_online_cpus(),
+			       TTM_MEMCPY_MAX_WORKERS);
+	struct ttm_memcpy_range *r;
+	unsigned long chunk;
+	unsigned int i;
+	int ret;
+
+	r = kmalloc_array(n, sizeof(*r), GFP_KERNEL);
+	if (!r)
+		return ttm_copy_range(tmpl);
+
+	chunk = DIV_ROUND_UP(num_pages, n);
+	for (i = 0; i < n; ++i) {
+		r[i] = *tmpl;
+		r[i].start = tmpl->start + i * chunk;
+		r[i].end = min(r[i].start + chunk, tmpl->end);
+		r[i].ret = 0;
+		INIT_WORK(&r[i].work, ttm_copy_range_work);
+		if (i)
+			queue_work(system_unbound_wq, &r[i].work);
+	}
+
+	ret = ttm_copy_range(&r[0]);
+	for (i = 1; i < n; ++i) {
+		flush_work(&r[i].work);
+		if (!ret)
+			ret = r[i].ret;
+	}
+
+	kfree(r);
+	return ret;
+}
+
 int ttm_bo_move_memcpy(struct ttm_buffer_object *bo,
 		       struct ttm_operation_ctx *ctx,
 		       struct ttm_mem_reg *new_mem)
@@ -362,13 +584,10 @@ int ttm_bo_move_memcpy(struct ttm_buffer_object *bo,
 	struct ttm_tt *ttm = bo->ttm;
 	struct ttm_mem_reg *old_mem = &bo->mem;
 	struct ttm_mem_reg old_copy = *old_mem;
+	struct ttm_memcpy_range range;
 	void *old_iomap;
 	void *new_iomap;
 	int ret;
-	unsigned long i;
-	unsigned long page;
-	unsigned long add = 0;
-	int dir;
 
 	ret = ttm_bo_wait(bo, ctx->interruptible, ctx->no_wait_gpu);
 	if (ret)
@@ -406,33 +625,30 @@ int ttm_bo_move_memcpy(struct ttm_buffer_object *bo,
 			goto out1;
 	}
 
-	add = 0;
-	dir = 1;
+	range.ttm = ttm;
+	range.old_iomap = old_iomap;
+	range.new_iomap = new_iomap;
+	range.old_mem = old_mem;
+	range.new_mem = new_mem;
+	range.start = 0;
+	range.end = new_mem->num_pages;
+	range.add = 0;
+	range.dir = 1;
 
 	if ((old_mem->mem_type == new_mem->mem_type) &&
 	    (new_mem->start < old_mem->start + old_mem->size)) {
-		dir = -1;
-		add = new_mem->num_pages - 1;
+		range.dir = -1;
+		range.add = new_mem->num_pages - 1;
 	}
 
-	for (i = 0; i < new_mem->num_pages; ++i) {
-		page = i * dir + add;
-		if (old_iomap == NULL) {
-			pgprot_t prot = ttm_io_prot(old_mem->placement,
-						    PAGE_KERNEL);
-			ret = ttm_copy_ttm_io_page(ttm, new_iomap, page,
-						   prot);
-		} else if (new_iomap == NULL) {
-			pgprot_t prot = ttm_io_prot(new_mem->placement,
-						    PAGE_KERNEL);
-			ret = ttm_copy_io_ttm_page(ttm, old_iomap, page,
-						   prot);
-		} else {
-			ret = ttm_copy_io_page(new_iomap, old_iomap, page);
-		}
-		if (ret)
-			goto out1;
-	}
+	/* Overlapping moves need to stay in order */
+	if (range.dir == 1 && new_mem->num_pages >= TTM_MEMCPY_PARALLEL_PAGES &&
+	    num_online_cpus() > 1)
+		ret = ttm_copy_parallel(&range);
+	else
+		ret = ttm_copy_range(&range);
+	if (ret)
+		goto out1;
 	mb();
 out2:
 	old_copy = *old_mem;
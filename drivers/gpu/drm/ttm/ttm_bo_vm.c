@@ -43,6 +43,52 @@
 #include <linux/mem_encrypt.h>
 
 #define TTM_BO_VM_NUM_PREFAULT 16
+#define TTM_BO_VM_MIN_PREFAULT 1
+/* One PMD-sized superpage worth of 4KiB pages. */
+#define TTM_BO_VM_MAX_PREFAULT 512
+
+/**
+ * ttm_bo_vm_prefault_window - Pick the number of pages to fault around
+ * @bo: The buffer object, reserved.
+ * @vma: The faulting vma.
+ * @page_offset: The faulting page offset within @bo.
+ *
+ * A fault on the page just past the ones prefaulted by the previous fault
+ * through the same vma means a sequential stream, so the window is doubled
+ * up to a superpage. Any other fault through the same vma is treated as
+ * random access and halves the window. A fault through a different vma
+ * restarts with the default window.
+ */
+static unsigned long ttm_bo_vm_prefault_window(struct ttm_buffer_object *bo,
+					       struct vm_area_struct *vma,
+					       unsigned long page_offset)
+{
+	if (bo->fault_vma != vma)
+		bo->fault_window = TTM_BO_VM_NUM_PREFAULT;
+	else if (page_offset == bo->fault_next)
+		bo->fault_window = min_t(unsigned int, bo->fault_window << 1,
+					 TTM_BO_VM_MAX_PREFAULT);
+	else
+		bo->fault_window = max_t(unsigned int, bo->fault_window >> 1,
+					 TTM_BO_VM_MIN_PREFAULT);
+
+	bo->fault_vma = vma;
+
+	return bo->fault_window;
+}
+
+static void ttm_bo_vm_prefault_done(struct ttm_buffer_object *bo,
+				    unsigned long page_next,
+				    unsigned long num_mapped)
+{
+	struct ttm_bo_global *glob = bo->bdev->glob;
+
+	bo->fault_next = page_next;
+
+	atomic_long_inc(&glob->vm_faults);
+	if (num_mapped > 1)
+		atomic_long_add(num_mapped - 1, &glob->vm_faults_saved);
+}
 
 static vm_fault_t ttm_bo_vm_fault_idle(struct ttm_buffer_object *bo,
 				struct vm_fault *vmf)
@@ -118,6 +164,7 @@ static vm_fault_t ttm_bo_vm_fault(struct vm_area_struct *dummy, struct vm_fault
 	struct ttm_bo_device *bdev = bo->bdev;
 	unsigned long page_offset;
 	unsigned long page_last;
+	unsigned long num_prefault;
 	unsigned long pfn;
 	struct ttm_tt *ttm = NULL;
 	struct page *page;
@@ -258,8 +305,9 @@ static vm_fault_t ttm_bo_vm_fault(struct vm_area_struct *dummy, struct vm_fault
 	 * Speculatively prefault a number of pages. Only error on
 	 * first page.
 	 */
+	num_prefault = ttm_bo_vm_prefault_window(bo, vma, page_offset);
 #ifdef __linux__
-	for (i = 0; i < TTM_BO_VM_NUM_PREFAULT; ++i) {
+	for (i = 0; i < num_prefault; ++i) {
 		if (bo->mem.bus.is_iomem) {
 			/* Iomem should not be marked encrypted */
 			cvma.vm_page_prot = pgprot_decrypted(cvma.vm_page_prot);
@@ -292,9 +340,12 @@ static vm_fault_t ttm_bo_vm_fault(struct vm_area_struct *dummy, struct vm_fault
 		}
 
 		address += PAGE_SIZE;
-		if (unlikely(++page_offset >= page_last))
+		if (unlikely(++page_offset >= page_last)) {
+			++i;
 			break;
+		}
 	}
+	ttm_bo_vm_prefault_done(bo, page_offset, i);
 #elif defined(__FreeBSD__)
 	vm_object_t obj;
 	vm_pindex_t pidx;
@@ -305,7 +356,7 @@ static vm_fault_t ttm_bo_vm_fault(struct vm_area_struct *dummy, struct vm_fault
 	vma->vm_pfn_first = pidx;
 
 	VM_OBJECT_WLOCK(obj);
-	for (i = 0; i < TTM_BO_VM_NUM_PREFAULT && page_offset < page_last;
+	for (i = 0; i < num_prefault && page_offset < page_last;
 	    i++, page_offset++, pidx++) {
 retry:
 		page = vm_page_grab(obj, pidx, VM_ALLOC_NOCREAT);
@@ -337,6 +388,8 @@ fail:
 		break;
 	}
 	VM_OBJECT_WUNLOCK(obj);
+	if (i != 0)
+		ttm_bo_vm_prefault_done(bo, page_offset, i);
 #endif
 out_io_unlock:
 	ttm_mem_io_unlock(man);
@@ -45,6 +45,28 @@
 
 #define TTM_MEMORY_ALLOC_RETRIES 4
 
+/*
+ * Amount of memory each CPU reserves from the zones at once, so that
+ * most allocations and frees only touch a per-CPU counter.
+ */
+#define TTM_MEMORY_CPU_BATCH (512ULL << 10)
+
+enum {
+	TTM_MEM_CPU_KERNEL,	/* Accounted in the kernel zone only */
+	TTM_MEM_CPU_ALL,	/* Accounted in all zones */
+	TTM_MEM_CPU_NUM
+};
+
+/**
+ * struct ttm_mem_cpu - Per-CPU memory accounting cache.
+ *
+ * @reserved: Memory accounted as used in the zones, but not yet handed out
+ * to an allocation, for each set of zones allocations may be charged to.
+ */
+struct ttm_mem_cpu {
+	atomic64_t reserved[TTM_MEM_CPU_NUM];
+} ____cacheline_aligned_in_smp;
+
 struct ttm_mem_global ttm_mem_glob;
 EXPORT_SYMBOL(ttm_mem_glob);
 
@@ -238,6 +260,156 @@ static struct kobj_type ttm_mem_glob_kobj_type = {
 	.default_attrs = ttm_mem_global_attrs,
 };
 
+static int ttm_mem_cpu_set(struct ttm_mem_global *glob,
+			   struct ttm_mem_zone *single_zone)
+{
+	if (!glob->cpus)
+		return -1;
+	if (!single_zone)
+		return TTM_MEM_CPU_ALL;
+	if (single_zone == glob->zone_kernel)
+		return TTM_MEM_CPU_KERNEL;
+	return -1;
+}
+
+static void ttm_mem_global_free_zone_locked(struct ttm_mem_global *glob,
+					    struct ttm_mem_zone *single_zone,
+					    uint64_t amount)
+{
+	unsigned int i;
+	struct ttm_mem_zone *zone;
+
+	for (i = 0; i < glob->num_zones; ++i) {
+		zone = glob->zones[i];
+		if (single_zone && zone != single_zone)
+			continue;
+		zone->used_mem -= amount;
+	}
+}
+
+/*
+ * Hand all memory cached by the CPUs back to the zones, so that the zone
+ * counters are exact. Only done when we are about to shrink.
+ */
+static void ttm_mem_cpu_drain(struct ttm_mem_global *glob)
+{
+	struct ttm_mem_cpu *cpu_cache;
+	uint64_t amount;
+	int cpu;
+
+	if (!glob->cpus)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		cpu_cache = &glob->cpus[cpu];
+
+		amount = atomic64_xchg(&cpu_cache->reserved[TTM_MEM_CPU_KERNEL],
+				       0);
+		if (amount) {
+			spin_lock(&glob->lock);
+			ttm_mem_global_free_zone_locked(glob, glob->zone_kernel,
+							amount);
+			spin_unlock(&glob->lock);
+		}
+
+		amount = atomic64_xchg(&cpu_cache->reserved[TTM_MEM_CPU_ALL], 0);
+		if (amount) {
+			spin_lock(&glob->lock);
+			ttm_mem_global_free_zone_locked(glob, NULL, amount);
+			spin_unlock(&glob->lock);
+		}
+	}
+}
+
+static bool ttm_mem_cpu_alloc(struct ttm_mem_global *glob,
+			      struct ttm_mem_zone *single_zone,
+			      uint64_t amount)
+{
+	int set = ttm_mem_cpu_set(glob, single_zone);
+	atomic64_t *reserved;
+	int64_t old;
+
+	if (set < 0)
+		return false;
+
+	reserved = &glob->cpus[get_cpu()].reserved[set];
+	put_cpu();
+
+	do {
+		old = atomic64_read(reserved);
+		if (old < amount)
+			return false;
+	} while (atomic64_cmpxchg(reserved, old, old - amount) != old);
+
+	return true;
+}
+
+static bool ttm_mem_cpu_free(struct ttm_mem_global *glob,
+			     struct ttm_mem_zone *single_zone,
+			     uint64_t amount)
+{
+	int set = ttm_mem_cpu_set(glob, single_zone);
+	atomic64_t *reserved;
+	int64_t old;
+
+	if (set < 0)
+		return false;
+
+	reserved = &glob->cpus[get_cpu()].reserved[set];
+	put_cpu();
+
+	if (atomic64_add_return(amount, reserved) <= 2 * TTM_MEMORY_CPU_BATCH)
+		return true;
+
+	/* Keep one batch cached and give the rest back to the zones. */
+	do {
+		old = atomic64_read(reserved);
+		if (old <= TTM_MEMORY_CPU_BATCH)
+			return true;
+	} while (atomic64_cmpxchg(reserved, old,
+				  TTM_MEMORY_CPU_BATCH) != old);
+
+	spin_lock(&glob->lock);
+	ttm_mem_global_free_zone_locked(glob, single_zone,
+					old - TTM_MEMORY_CPU_BATCH);
+	spin_unlock(&glob->lock);
+
+	return true;
+}
+
+/*
+ * How much to reserve on top of an allocation to refill the per-CPU cache.
+ * Nothing if that would bring any zone close to its swap limit, so the
+ * zone counters stay exact where ttm_check_swapping() looks at them.
+ */
+static uint64_t ttm_mem_cpu_refill(struct ttm_mem_global *glob,
+				   struct ttm_mem_zone *single_zone,
+				   uint64_t amount)
+{
+	uint64_t extra = TTM_MEMORY_CPU_BATCH;
+	struct ttm_mem_zone *zone;
+	unsigned int i;
+
+	if (ttm_mem_cpu_set(glob, single_zone) < 0)
+		return 0;
+
+	spin_lock(&glob->lock);
+	for (i = 0; i < glob->num_zones; ++i) {
+		zone = glob->zones[i];
+		if (single_zone && zone != single_zone)
+			continue;
+		if (zone->used_mem + amount +
+		    num_online_cpus() * 2 * TTM_MEMORY_CPU_BATCH >
+		    zone->swap_limit) {
+			extra = 0;
+			break;
+		}
+	}
+	spin_unlock(&glob->lock);
+
+	return extra;
+}
+
 static bool ttm_zones_above_swap_target(struct ttm_mem_global *glob,
 					bool from_wq, uint64_t extra)
 {
@@ -279,11 +451,14 @@ static void ttm_shrink(struct ttm_mem_global *glob, bool from_wq,
 {
 	int ret;
 
+	ttm_mem_cpu_drain(glob);
+
 	spin_lock(&glob->lock);
 
 	while (ttm_zones_above_swap_target(glob, from_wq, extra)) {
 		spin_unlock(&glob->lock);
 		ret = ttm_bo_swapout(glob->bo_glob, ctx);
+		ttm_mem_cpu_drain(glob);
 		spin_lock(&glob->lock);
 		if (unlikely(ret != 0))
 			break;
@@ -428,12 +603,17 @@ int ttm_mem_global_init(struct ttm_mem_global *glob)
 	struct ttm_mem_zone *zone;
 
 	spin_lock_init(&glob->lock);
+	glob->cpus = kcalloc(nr_cpu_ids, sizeof(*glob->cpus), GFP_KERNEL);
+	if (unlikely(!glob->cpus))
+		return -ENOMEM;
 	glob->swap_queue = create_singlethread_workqueue("ttm_swap");
 	INIT_WORK(&glob->work, ttm_shrink_work);
 	ret = kobject_init_and_add(
 		&glob->kobj, &ttm_mem_glob_kobj_type, ttm_get_kobj(), "memory_accounting");
 	if (unlikely(ret != 0)) {
 		kobject_put(&glob->kobj);
+		kfree(glob->cpus);
+		glob->cpus = NULL;
 		return ret;
 	}
 
@@ -479,6 +659,9 @@ void ttm_mem_global_release(struct ttm_mem_global *glob)
 	flush_workqueue(glob->swap_queue);
 	destroy_workqueue(glob->swap_queue);
 	glob->swap_queue = NULL;
+	ttm_mem_cpu_drain(glob);
+	kfree(glob->cpus);
+	glob->cpus = NULL;
 	for (i = 0; i < glob->num_zones; ++i) {
 		zone = glob->zones[i];
 		kobject_del(&zone->kobj);
@@ -515,16 +698,11 @@ static void ttm_mem_global_free_zone(struct ttm_mem_global *glob,
 				     struct ttm_mem_zone *single_zone,
 				     uint64_t amount)
 {
-	unsigned int i;
-	struct ttm_mem_zone *zone;
+	if (ttm_mem_cpu_free(glob, single_zone, amount))
+		return;
 
 	spin_lock(&glob->lock);
-	for (i = 0; i < glob->num_zones; ++i) {
-		zone = glob->zones[i];
-		if (single_zone && zone != single_zone)
-			continue;
-		zone->used_mem -= amount;
-	}
+	ttm_mem_global_free_zone_locked(glob, single_zone, amount);
 	spin_unlock(&glob->lock);
 }
 
@@ -615,18 +793,27 @@ static int ttm_mem_global_alloc_zone(struct ttm_mem_global *glob,
 				     struct ttm_operation_ctx *ctx)
 {
 	int count = TTM_MEMORY_ALLOC_RETRIES;
+	uint64_t extra;
 
+	if (ttm_mem_cpu_alloc(glob, single_zone, memory))
+		return 0;
+
+	extra = ttm_mem_cpu_refill(glob, single_zone, memory);
 	while (unlikely(ttm_mem_global_reserve(glob,
 					       single_zone,
-					       memory, true)
+					       memory + extra, true)
 			!= 0)) {
 		if (ctx->no_wait_gpu)
 			return -ENOMEM;
 		if (unlikely(count-- == 0))
 			return -ENOMEM;
+		extra = 0;
 		ttm_shrink(glob, false, memory + (memory >> 2) + 16, ctx);
 	}
 
+	if (extra)
+		ttm_mem_cpu_free(glob, single_zone, extra);
+
 	return 0;
 }
 
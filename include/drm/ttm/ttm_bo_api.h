@@ -155,6 +155,9 @@ struct ttm_tt;
  * @offset: The current GPU offset, which can have different meanings
  * depending on the memory type. For SYSTEM type memory, it should be 0.
  * @cur_placement: Hint of current placement.
+ * @fault_vma: The vma that last faulted on this buffer object.
+ * @fault_next: Page offset following the last page prefaulted for @fault_vma.
+ * @fault_window: Current number of pages to prefault for @fault_vma.
  * @wu_mutex: Wait unreserved mutex.
  *
  * Base class for TTM buffer object, that deals with data placement and CPU
@@ -220,6 +223,14 @@ struct ttm_buffer_object {
 	struct dma_fence *moving;
 	unsigned priority;
 
+	/*
+	 * CPU fault-around state. @fault_vma is only ever compared
+	 * against, never dereferenced.
+	 */
+	const void *fault_vma;
+	unsigned long fault_next;
+	unsigned int fault_window;
+
 	/**
 	 * Special members that are protected by the reserve lock
 	 * and the bo::lock when written to. Can be read with
@@ -414,6 +425,20 @@ void ttm_bo_move_to_lru_tail(struct ttm_buffer_object *bo,
  */
 void ttm_bo_bulk_move_lru_tail(struct ttm_lru_bulk_move *bulk);
 
+/**
+ * ttm_bo_bulk_move_at_tail
+ *
+ * @bulk: bulk move structure
+ *
+ * Returns true if every range recorded in @bulk already ends at the tail of
+ * its LRU list, in which case ttm_bo_bulk_move_lru_tail() would be a no-op.
+ * May be called without ttm_bo_global::lru_lock held, so that callers which
+ * bump the same working set on every submission can skip taking the lock.
+ * The lockless answer may be stale; the worst outcome is a missed LRU bump.
+ * The BOs in @bulk must be reserved.
+ */
+bool ttm_bo_bulk_move_at_tail(struct ttm_lru_bulk_move *bulk);
+
 /**
  * ttm_bo_lock_delayed_workqueue
  *
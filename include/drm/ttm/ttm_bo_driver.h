@@ -425,6 +425,9 @@ struct ttm_bo_driver {
  * @lru_lock: Spinlock protecting the bo subsystem lru lists.
  * @device_list: List of buffer object devices.
  * @swap_lru: Lru list of buffer objects used for swapping.
+ * @vm_faults: Number of CPU page faults taken on buffer object mappings.
+ * @vm_faults_saved: Number of pages mapped ahead of the faulting page,
+ * i.e. faults avoided for CPU accesses that hit those pages later.
  */
 
 extern struct ttm_bo_global {
@@ -452,6 +455,8 @@ extern struct ttm_bo_global {
 	 * Internal protection.
 	 */
 	atomic_t bo_count;
+	atomic_long_t vm_faults;
+	atomic_long_t vm_faults_saved;
 } ttm_bo_glob;
 
 
@@ -56,6 +56,8 @@
  * @zone_kernel: Pointer to the kernel zone.
  * @zone_highmem: Pointer to the highmem zone if there is one.
  * @zone_dma32: Pointer to the dma32 zone if there is one.
+ * @cpus: Per-CPU caches of memory already accounted in the zones. Zone
+ * usage includes these, and they are handed back before shrinking.
  *
  * Note that this structure is not per device. It should be global for all
  * graphics devices.
@@ -63,6 +65,7 @@
 
 #define TTM_MEM_MAX_ZONES 2
 struct ttm_mem_zone;
+struct ttm_mem_cpu;
 extern struct ttm_mem_global {
 	struct kobject kobj;
 	struct ttm_bo_global *bo_glob;
@@ -78,6 +81,7 @@ extern struct ttm_mem_global {
 #else
 	struct ttm_mem_zone *zone_dma32;
 #endif
+	struct ttm_mem_cpu *cpus;
 } ttm_mem_glob;
 
 extern int ttm_mem_global_init(struct ttm_mem_global *glob);